@@ -0,0 +1,141 @@
+#!/bin/sh
+# Consistency checks of the program. Each check runs the same orders two ways which must give the same output and
+# prints PASS or FAIL with the first differences. The programs are built in a temporary directory and run from the
+# directory of this script, which provides info.dat.
+# Usage: ./check.sh [threads]
+
+threads=${1:-4}
+cd "$(dirname "$0")" || exit 1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+failed=0
+
+library="order_system.c order_reader.c order_merge.c order_sort.c scheduler.c intern_table.c order_store.c order_file.c daily_stats.c work_pool.c sweep.c stock.c metrics.c event_log.c"
+gcc -O2 -o "$dir/main" main.c $library order_server.c snapshot.c customer_stats.c order_manifest.c -lm -lpthread || exit 1
+gcc -O2 -o "$dir/order_generate" order_generate.c order_generator.c $library -lm -lpthread || exit 1
+
+# Compares two output files.
+# $1 name of the check, $2 and $3 the files.
+compare() {
+    if cmp -s "$2" "$3"; then
+        echo "PASS $1"
+    else
+        echo "FAIL $1"
+        diff "$2" "$3" | head -n 10
+        failed=1
+    fi
+}
+
+# Writes a generated orders file of about two parallel chunks (ORDER_READER_CHUNK_SIZE is 4 MiB). The line across
+# each chunk boundary is overwritten with a malformed line of the same length and a last line without its new line
+# is appended, so the boundaries and the end of the file both fall on lines the reader has to handle.
+# $1 file name.
+generate_orders() {
+    "$dir/order_generate" --orders 400000 --customers 20000 --seed 11 "$1" > /dev/null || exit 1
+    printf '999999 A 2 Clast' >> "$1"
+    size=$(wc -c < "$1")
+    awk -v size="$size" -v chunk=4194304 '
+        BEGIN { count = int((size + chunk - 1) / chunk); next_chunk = 1 }
+        {
+            end = start + length($0) + 1
+            boundary = int(size * next_chunk / count)
+            if (next_chunk < count && start < boundary && boundary <= end) {
+                line = $0
+                gsub(/./, "x", line)
+                $0 = line
+                next_chunk++
+            }
+            printf "%s%s", $0, (end > size ? "" : "\n")
+            start = end
+        }' "$1" > "$1.tmp" && mv "$1.tmp" "$1"
+}
+
+generate_orders "$dir/orders.dat"
+
+# --threads 1 against --threads N: the parallel reader must give the same orders, customer ids and messages.
+"$dir/main" --quiet --models --top 5 --threads 1 "$dir/orders.dat" > "$dir/threads_1.txt"
+"$dir/main" --quiet --models --top 5 --threads "$threads" "$dir/orders.dat" > "$dir/threads_n.txt"
+compare "threads 1 against threads $threads" "$dir/threads_1.txt" "$dir/threads_n.txt"
+
+# Radix sort against a reference sort: the orders table printed before the simulation must be sorted by timestamp,
+# then by quantity and then by margin of the model (both largest first), ties keeping the order of the file.
+"$dir/order_generate" --orders 100000 --customers 500 --burst 8 --quantity 3 --seed 5 "$dir/sort.dat" > /dev/null || exit 1
+"$dir/main" --events "$dir/sort.bin" "$dir/sort.dat" | awk '/^Policy/ { exit } table; /^ *Customer/ { table = 1 }' > "$dir/sort_radix.txt"
+awk 'NR == FNR { if (FNR > 1) margin[$1] = $3 - $2; next } { print $1, $3, margin[$2], FNR, $2, $4 }' info.dat "$dir/sort.dat" \
+    | sort -k1,1n -k2,2nr -k3,3nr -k4,4n \
+    | awk '{ printf "%14s  %14d  %14s  %14d\n", $6, $2, $5, $1 }' > "$dir/sort_reference.txt"
+compare "radix sort against a reference sort" "$dir/sort_reference.txt" "$dir/sort_radix.txt"
+
+# Writes the commands of a server session from lines of an orders file: the orders, an ADVANCE every 50 orders and
+# a query or a cancellation now and then. The server is started on orders.dat, so the first command gets id 12.
+# $1 orders file, $2 and $3 first and last line used.
+server_commands() {
+    awk -v first="$2" -v last="$3" 'NR >= first && NR <= last {
+        print "ORDER " $0
+        if (NR % 50 == 0) print "ADVANCE 24"
+        if (NR % 70 == 0) print "CANCEL " (NR - 9)
+        if (NR % 200 == 0) print "REVENUE 1 " $1
+        if (NR % 300 == 0) print "ITEMS " $2 " 1 " $1
+        if (NR % 500 == 0) print "STATS"
+    }' "$1"
+}
+
+# Snapshot round trip: a server restored from a snapshot must answer the commands which follow as the server which
+# wrote it does.
+server_commands "$dir/sort.dat" 1 3000 > "$dir/before.txt"
+echo "SNAPSHOT $dir/state.snap" >> "$dir/before.txt"
+server_commands "$dir/sort.dat" 3001 6000 > "$dir/after.txt"
+printf 'ADVANCE 100000\nSTATS\nQUIT\n' >> "$dir/after.txt"
+after=$(wc -l < "$dir/after.txt")
+cat "$dir/before.txt" "$dir/after.txt" | "$dir/main" --serve - --quiet orders.dat | tail -n "$after" > "$dir/served.txt"
+"$dir/main" --restore "$dir/state.snap" --serve - --quiet < "$dir/after.txt" | tail -n "$after" > "$dir/restored.txt"
+compare "snapshot round trip" "$dir/served.txt" "$dir/restored.txt"
+
+# Writes an output of main without the names of the files read and with the customers of the sold items statistics
+# in order of name, since merged files number the customers in order of their first order in time.
+# $1 output file, $2 normalised file.
+normalise() {
+    awk -v customers="$2.customers" '
+        /^File .* opened successfully$/ { next }
+        /^Customer name:/ { if (customer != "") print customer | ("sort > " customers); customer = $0; next }
+        customer != "" && /^Model . items sold:/ { customer = customer " " $0; next }
+        customer != "" { print customer | ("sort > " customers); customer = "" }
+        { print }
+        END { if (customer != "") print customer | ("sort > " customers); close("sort > " customers) }' "$1" > "$2"
+    cat "$2.customers" >> "$2" 2> /dev/null
+}
+
+# Merge against concatenation: three sorted files merged while they are read must give the orders, simulation and
+# statistics of the same files concatenated into one unsorted file.
+awk -v dir="$dir" '{ print > (dir "/merge" (NR % 3) ".dat") }' "$dir/sort.dat"
+cat "$dir/merge0.dat" "$dir/merge1.dat" "$dir/merge2.dat" > "$dir/merge.dat"
+"$dir/main" --models --top 5 "$dir/merge0.dat" "$dir/merge1.dat" "$dir/merge2.dat" > "$dir/merged_raw.txt" 2>&1
+"$dir/main" --models --top 5 "$dir/merge.dat" > "$dir/concatenated_raw.txt" 2>&1
+normalise "$dir/merged_raw.txt" "$dir/merged.txt"
+normalise "$dir/concatenated_raw.txt" "$dir/concatenated.txt"
+compare "merge against concatenation" "$dir/concatenated.txt" "$dir/merged.txt"
+
+# Resumed against fresh --incremental: the file is appended to twice, at the end of a day, and the run resumed after
+# each part must give the figures of a run of the whole file from scratch. The lines counting the orders read and
+# telling how the file was read differ.
+# $1 output file, $2 filtered file.
+incremental_figures() {
+    grep -Ev '^(File .* opened successfully|Reading the whole|Resumed|Orders found|New orders)' "$1" > "$2"
+}
+
+cp "$dir/sort.dat" "$dir/fresh.dat"
+"$dir/main" --incremental --quiet --models --top 5 "$dir/fresh.dat" > "$dir/fresh_raw.txt" 2>&1
+lines=$(wc -l < "$dir/sort.dat")
+awk -v lines="$lines" -v dir="$dir" '
+    NR > 1 && $1 != previous && part < 2 && NR > lines * (part + 1) / 3 { part++ }
+    { print > (dir "/part" (part + 0) ".dat"); previous = $1 }' "$dir/sort.dat"
+: > "$dir/resumed.dat"
+for part in 0 1 2; do
+    cat "$dir/part$part.dat" >> "$dir/resumed.dat"
+    "$dir/main" --incremental --quiet --models --top 5 "$dir/resumed.dat" > "$dir/resumed_raw.txt" 2>&1
+done
+incremental_figures "$dir/fresh_raw.txt" "$dir/fresh.txt"
+incremental_figures "$dir/resumed_raw.txt" "$dir/resumed.txt"
+compare "resumed against fresh incremental run" "$dir/fresh.txt" "$dir/resumed.txt"
+
+exit $failed
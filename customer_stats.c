@@ -0,0 +1,287 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "customer_stats.h"
+#include "order_sort.h"
+
+/**
+ * Day of the latest order of a customer, first_day - 1 for a customer without orders.
+ */
+static int latest_day(struct CustomerIndex *index, int customer) {
+    int end = index->offsets[customer + 1];
+
+    return end > index->offsets[customer] ? index->days[end - 1] : index->first_day - 1;
+}
+
+/**
+ * Builds the index of the orders of each customer. The entries are sorted by customer and then by day with one radix
+ * sort, so the orders may come in any order; the orders of a customer on the same day keep their relative order.
+ * Orders whose customer id is out of the table are left out.
+ * @param index Pointer reference to the CustomerIndex struct to fill.
+ * @param orders Pointer reference to the array of Order structs.
+ * @param orders_count Number of orders.
+ * @param catalog Pointer reference to the ModelCatalog struct giving the price and cost of each model.
+ * @param customer_count Number of customers in the customer table.
+ */
+void customer_index_build(struct CustomerIndex *index, const struct Order *orders, int orders_count, struct ModelCatalog *catalog, int customer_count) {
+    int i, count = 0, time_bits, max_day;
+    size_t customers = customer_count > 0 ? (size_t)customer_count : 1;
+    struct SortKeys keys;
+
+    index->customer_count = customer_count;
+    index->first_day = 0;
+    max_day = -1;
+    for (i = 0; i < orders_count; ++i) {
+        if (orders[i].customer_id < 0 || orders[i].customer_id >= customer_count) {
+            continue;
+        }
+        if (count == 0 || orders[i].timestamp < index->first_day) index->first_day = orders[i].timestamp;
+        if (count == 0 || orders[i].timestamp > max_day) max_day = orders[i].timestamp;
+        count++;
+    }
+    index->last_day = count > 0 ? max_day : index->first_day - 1;
+
+    index->offsets = calloc(customers + 1, sizeof(int));
+    index->orders = malloc((count > 0 ? (size_t)count : 1) * sizeof(int));
+    index->days = malloc((count > 0 ? (size_t)count : 1) * sizeof(int));
+    index->revenue = malloc((count > 0 ? (size_t)count : 1) * sizeof(double));
+    index->margin = malloc((count > 0 ? (size_t)count : 1) * sizeof(double));
+    index->by_last_day = malloc(customers * sizeof(int));
+    if (index->offsets == NULL || index->orders == NULL || index->days == NULL || index->revenue == NULL
+        || index->margin == NULL || index->by_last_day == NULL) {
+        printf("Error! not enough memory for the orders of %d customers\n", customer_count);
+        exit(0);
+    }
+
+    time_bits = count > 0 ? bits_needed((uint64_t)(index->last_day - index->first_day)) : 0;
+    sort_keys_init(&keys, count);
+    count = 0;
+    for (i = 0; i < orders_count; ++i) {
+        if (orders[i].customer_id < 0 || orders[i].customer_id >= customer_count) {
+            continue;
+        }
+        keys.key[count] = ((uint64_t)orders[i].customer_id << time_bits) | (uint64_t)(orders[i].timestamp - index->first_day);
+        keys.index[count++] = (uint32_t)i;
+        index->offsets[orders[i].customer_id + 1]++;
+    }
+    radix_sort_keys(&keys, time_bits + bits_needed((uint64_t)customer_count));
+    for (i = 0; i < customer_count; ++i) {
+        index->offsets[i + 1] += index->offsets[i];
+    }
+
+    for (i = 0; i < count; ++i) {
+        const struct Order *order = &orders[keys.index[i]];
+        bool first = i == index->offsets[order->customer_id];
+        double revenue = 0, margin = 0;
+
+        if (order->model_id >= 0 && order->model_id < catalog->count) {
+            revenue = (double)catalog->models[order->model_id].price * order->quantity;
+            margin = ((double)catalog->models[order->model_id].price - catalog->models[order->model_id].cost) * order->quantity;
+        }
+        index->orders[i] = (int)keys.index[i];
+        index->days[i] = order->timestamp;
+        index->revenue[i] = (first ? 0 : index->revenue[i - 1]) + revenue;
+        index->margin[i] = (first ? 0 : index->margin[i - 1]) + margin;
+    }
+    sort_keys_free(&keys);
+
+    sort_keys_init(&keys, customer_count);
+    for (i = 0; i < customer_count; ++i) {
+        keys.key[i] = (uint64_t)(latest_day(index, i) - (index->first_day - 1));
+    }
+    radix_sort_keys(&keys, bits_needed((uint64_t)(index->last_day - (index->first_day - 1))));
+    for (i = 0; i < customer_count; ++i) {
+        index->by_last_day[i] = (int)keys.index[i];
+    }
+    sort_keys_free(&keys);
+}
+
+/**
+ * Releases the memory of the index.
+ * @param index Pointer reference to the CustomerIndex struct.
+ */
+void customer_index_free(struct CustomerIndex *index) {
+    free(index->offsets);
+    free(index->orders);
+    free(index->days);
+    free(index->revenue);
+    free(index->margin);
+    free(index->by_last_day);
+}
+
+/**
+ * Gives the first entry of a customer whose day is after the given day, searching offsets[customer] to end.
+ */
+static int first_entry_after(struct CustomerIndex *index, int customer, int day) {
+    int low = index->offsets[customer], high = index->offsets[customer + 1];
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+
+        if (index->days[middle] <= day) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * Sums the revenue and the margin of the orders of a customer placed between two days, both included, in
+ * O(log orders of the customer).
+ * @param index Pointer reference to the CustomerIndex struct.
+ * @param customer Id of the customer.
+ * @param first_day First day of the range.
+ * @param last_day Last day of the range.
+ * @param revenue Pointer receiving the revenue.
+ * @param margin Pointer receiving the margin.
+ */
+void customer_index_range(struct CustomerIndex *index, int customer, int first_day, int last_day, double *revenue, double *margin) {
+    int begin, end;
+
+    *revenue = 0;
+    *margin = 0;
+    if (customer < 0 || customer >= index->customer_count || first_day > last_day) {
+        return;
+    }
+    begin = first_day > INT_MIN ? first_entry_after(index, customer, first_day - 1) : index->offsets[customer];
+    end = first_entry_after(index, customer, last_day);
+    if (begin == end) {
+        return;
+    }
+    *revenue = index->revenue[end - 1] - (begin > index->offsets[customer] ? index->revenue[begin - 1] : 0);
+    *margin = index->margin[end - 1] - (begin > index->offsets[customer] ? index->margin[begin - 1] : 0);
+}
+
+/**
+ * Total revenue or margin of a customer, the running sum of its latest order.
+ */
+static double customer_total(struct CustomerIndex *index, int customer, bool by_margin) {
+    int end = index->offsets[customer + 1];
+
+    if (end == index->offsets[customer]) {
+        return 0;
+    }
+    return by_margin ? index->margin[end - 1] : index->revenue[end - 1];
+}
+
+/**
+ * Tells whether the heap entry at position a ranks below the one at position b: a smaller total, or the same total
+ * and a larger customer id.
+ */
+static bool ranks_below(const double *totals, const int *customers, int a, int b) {
+    return totals[a] != totals[b] ? totals[a] < totals[b] : customers[a] > customers[b];
+}
+
+/**
+ * Moves the entry at the given position of the min-heap of the top customers down to its place.
+ */
+static void top_sift_down(double *totals, int *customers, int count, int position) {
+    for (;;) {
+        int child = 2 * position + 1;
+        double total;
+        int customer;
+
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && ranks_below(totals, customers, child + 1, child)) {
+            child++;
+        }
+        if (!ranks_below(totals, customers, child, position)) {
+            break;
+        }
+        total = totals[child];
+        customer = customers[child];
+        totals[child] = totals[position];
+        customers[child] = customers[position];
+        totals[position] = total;
+        customers[position] = customer;
+        position = child;
+    }
+}
+
+/**
+ * Finds the customers with the highest total revenue or margin. A min-heap of the best k customers seen so far is
+ * kept while the totals are read from the index, so the search costs O(customers log k) and no sort of every
+ * customer. Equal totals rank the smaller customer id first.
+ * @param index Pointer reference to the CustomerIndex struct.
+ * @param k Number of customers wanted.
+ * @param by_margin Ranks by margin if true, by revenue otherwise.
+ * @param customers Array of k entries receiving the customer ids, best first.
+ * @param totals Array of k entries receiving the total of each customer.
+ * @return Returns the number of customers given, at most k.
+ */
+int customer_index_top(struct CustomerIndex *index, int k, bool by_margin, int *customers, double *totals) {
+    int i, count = 0;
+
+    if (k <= 0) {
+        return 0;
+    }
+    for (i = 0; i < index->customer_count; ++i) {
+        double total = customer_total(index, i, by_margin);
+
+        if (count < k) {
+            int position = count++;
+
+            totals[position] = total;
+            customers[position] = i;
+            while (position > 0 && ranks_below(totals, customers, position, (position - 1) / 2)) {
+                int parent = (position - 1) / 2;
+                double parent_total = totals[parent];
+                int parent_customer = customers[parent];
+
+                totals[parent] = totals[position];
+                customers[parent] = customers[position];
+                totals[position] = parent_total;
+                customers[position] = parent_customer;
+                position = parent;
+            }
+        } else if (total > totals[0]) {
+            totals[0] = total;
+            customers[0] = i;
+            top_sift_down(totals, customers, count, 0);
+        }
+    }
+
+    /* Pops the worst customer to the end of the arrays until the heap is empty, leaving them best first. */
+    for (i = count - 1; i > 0; --i) {
+        double total = totals[0];
+        int customer = customers[0];
+
+        totals[0] = totals[i];
+        customers[0] = customers[i];
+        totals[i] = total;
+        customers[i] = customer;
+        top_sift_down(totals, customers, i, 0);
+    }
+    return count;
+}
+
+/**
+ * Finds the customers without orders in the last days of the history, the days up to the latest order of any
+ * customer. The customers are kept sorted by the day of their latest order, so the search is one binary search.
+ * @param index Pointer reference to the CustomerIndex struct.
+ * @param days Number of days, the latest day included.
+ * @param customers Pointer receiving the array of the customer ids, oldest latest order first, owned by the index.
+ * @return Returns the number of customers found.
+ */
+int customer_index_inactive(struct CustomerIndex *index, int days, const int **customers) {
+    int low = 0, high = index->customer_count;
+    long long cutoff = (long long)index->last_day - days + 1;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+
+        if (latest_day(index, index->by_last_day[middle]) < cutoff) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    *customers = index->by_last_day;
+    return low;
+}
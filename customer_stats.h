@@ -0,0 +1,31 @@
+#ifndef ORDER_SYSTEM_CUSTOMER_STATS_H
+#define ORDER_SYSTEM_CUSTOMER_STATS_H
+#include <stdio.h>
+#include <stdbool.h>
+#include "order_system.h"
+/** @file */
+
+/**
+ * Orders of each customer in time order, in compressed sparse rows: the entries of customer c are offsets[c] to
+ * offsets[c + 1] - 1. Each entry carries the running revenue and margin of the customer up to that order, so the
+ * revenue of a customer over any range of days takes two binary searches, O(log orders of the customer).
+ */
+struct CustomerIndex {
+    int customer_count; /**< Number of customers. */
+    int *offsets; /**< First entry of each customer, customer_count + 1 entries. */
+    int *orders; /**< Position of the order of each entry in the orders array. */
+    int *days; /**< Day of the order of each entry, increasing within a customer. */
+    double *revenue; /**< Revenue of the orders of the customer up to this entry included. */
+    double *margin; /**< Margin (sale - cost) of the orders of the customer up to this entry included. */
+    int *by_last_day; /**< Customers sorted by the day of their latest order, oldest first; customers without orders come first. */
+    int first_day; /**< Day of the earliest order. */
+    int last_day; /**< Day of the latest order, first_day - 1 without orders. */
+};
+
+void customer_index_build(struct CustomerIndex *, const struct Order *, int, struct ModelCatalog *, int);
+void customer_index_free(struct CustomerIndex *);
+void customer_index_range(struct CustomerIndex *, int, int, int, double *, double *);
+int customer_index_top(struct CustomerIndex *, int, bool, int *, double *);
+int customer_index_inactive(struct CustomerIndex *, int, const int **);
+
+#endif //ORDER_SYSTEM_CUSTOMER_STATS_H
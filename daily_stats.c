@@ -0,0 +1,665 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "daily_stats.h"
+
+/**
+ * Lowest set bit of a Fenwick index.
+ */
+static int low_bit(int i) {
+    return i & -i;
+}
+
+/**
+ * Turns a Fenwick tree of doubles into the raw bucket values, undoing fenwick_build_double.
+ */
+static void fenwick_raw_double(double *tree, int size) {
+    int i;
+
+    for (i = size; i >= 1; --i) {
+        if (i + low_bit(i) <= size) {
+            tree[i + low_bit(i)] -= tree[i];
+        }
+    }
+}
+
+/**
+ * Turns raw bucket values into a Fenwick tree of doubles in O(size).
+ */
+static void fenwick_build_double(double *tree, int size) {
+    int i;
+
+    for (i = 1; i <= size; ++i) {
+        if (i + low_bit(i) <= size) {
+            tree[i + low_bit(i)] += tree[i];
+        }
+    }
+}
+
+/**
+ * Turns a Fenwick tree of integers into the raw bucket values, undoing fenwick_build_long.
+ */
+static void fenwick_raw_long(long long *tree, int size) {
+    int i;
+
+    for (i = size; i >= 1; --i) {
+        if (i + low_bit(i) <= size) {
+            tree[i + low_bit(i)] -= tree[i];
+        }
+    }
+}
+
+/**
+ * Turns raw bucket values into a Fenwick tree of integers in O(size).
+ */
+static void fenwick_build_long(long long *tree, int size) {
+    int i;
+
+    for (i = 1; i <= size; ++i) {
+        if (i + low_bit(i) <= size) {
+            tree[i + low_bit(i)] += tree[i];
+        }
+    }
+}
+
+/**
+ * Sum of the buckets 1..i of a Fenwick tree of doubles.
+ */
+static double fenwick_prefix_double(double *tree, int i) {
+    double sum = 0;
+
+    for (; i > 0; i -= low_bit(i)) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+/**
+ * Sum of the buckets 1..i of a Fenwick tree of integers.
+ */
+static long long fenwick_prefix_long(long long *tree, int i) {
+    long long sum = 0;
+
+    for (; i > 0; i -= low_bit(i)) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+/**
+ * Fills the entry of a new last bucket of a Fenwick tree of doubles of size n, the bucket being zero.
+ */
+static void fenwick_append_double(double *tree, int n) {
+    tree[n + 1] = fenwick_prefix_double(tree, n) - fenwick_prefix_double(tree, n + 1 - low_bit(n + 1));
+}
+
+/**
+ * Fills the entry of a new last bucket of a Fenwick tree of integers of size n, the bucket being zero.
+ */
+static void fenwick_append_long(long long *tree, int n) {
+    tree[n + 1] = fenwick_prefix_long(tree, n) - fenwick_prefix_long(tree, n + 1 - low_bit(n + 1));
+}
+
+/**
+ * Allocates a days array with room for capacity days.
+ */
+static int *allocate_days(int capacity) {
+    int *days = malloc((capacity > 0 ? capacity : 1) * sizeof(int));
+
+    if (days == NULL) {
+        printf("Error! not enough memory for %d days of statistics\n", capacity);
+        exit(0);
+    }
+    return days;
+}
+
+/**
+ * Allocates zeroed revenue and margin trees with room for the given number of days.
+ */
+static void allocate_trees(struct DailyAggregates *aggregates, int capacity) {
+    aggregates->capacity = capacity;
+    aggregates->revenue = calloc((size_t)capacity + 1, sizeof(double));
+    aggregates->margin = calloc((size_t)capacity + 1, sizeof(double));
+
+    if (aggregates->revenue == NULL || aggregates->margin == NULL) {
+        printf("Error! not enough memory for %d days of statistics\n", capacity);
+        exit(0);
+    }
+}
+
+/**
+ * Gives the number of days up to the given day included in an increasing days array, which is also the Fenwick index
+ * of the day when it is in the array.
+ */
+static int days_up_to(const int *days, int count, long long day) {
+    int low = 0, high = count;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+
+        if (days[middle] <= day) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * Merges two increasing days arrays, keeping each day once.
+ * @return Returns the number of days written to merged.
+ */
+static int merge_days(const int *a, int a_count, const int *b, int b_count, int *merged) {
+    int i = 0, j = 0, k = 0;
+
+    while (i < a_count || j < b_count) {
+        if (j == b_count || (i < a_count && a[i] <= b[j])) {
+            if (j < b_count && a[i] == b[j]) {
+                j++;
+            }
+            merged[k++] = a[i++];
+        } else {
+            merged[k++] = b[j++];
+        }
+    }
+    return k;
+}
+
+/**
+ * Moves the raw revenue and margin buckets onto new days, which must include the current ones, with room for
+ * capacity days. The new days are taken over. The trees are left raw.
+ */
+static void relayout(struct DailyAggregates *aggregates, int *days, int count, int capacity) {
+    struct DailyAggregates old = *aggregates;
+    int i, j = 0;
+
+    allocate_trees(aggregates, capacity);
+    for (i = 0; i < old.count; ++i) {
+        while (days[j] != old.days[i]) {
+            j++;
+        }
+        aggregates->revenue[j + 1] = old.revenue[i + 1];
+        aggregates->margin[j + 1] = old.margin[i + 1];
+    }
+    aggregates->days = days;
+    aggregates->count = count;
+    if (count > 0) {
+        aggregates->first_day = days[0];
+        aggregates->last_day = days[count - 1];
+    }
+    free(old.days);
+    free(old.revenue);
+    free(old.margin);
+}
+
+/**
+ * Moves the raw quantities of a model onto new days, which must include the current ones, with room for capacity
+ * days. The new days are taken over. The tree is left raw.
+ */
+static void model_relayout(struct ModelDays *model, int *days, int count, int capacity) {
+    long long *quantity = calloc((size_t)capacity + 1, sizeof(long long));
+    int i, j = 0;
+
+    if (quantity == NULL) {
+        printf("Error! not enough memory for %d days of statistics\n", capacity);
+        exit(0);
+    }
+    for (i = 0; i < model->count; ++i) {
+        while (days[j] != model->days[i]) {
+            j++;
+        }
+        quantity[j + 1] = model->quantity[i + 1];
+    }
+    free(model->days);
+    free(model->quantity);
+    model->days = days;
+    model->quantity = quantity;
+    model->count = count;
+    model->capacity = capacity;
+}
+
+/**
+ * Prepares empty aggregates. No model has a tree until it gets an order.
+ * @param aggregates Pointer reference to the DailyAggregates struct.
+ * @param models Pointer reference to the array of ModelInfo structs, model ids index it.
+ * @param model_count Number of models.
+ */
+void daily_aggregates_init(struct DailyAggregates *aggregates, struct ModelInfo *models, int model_count) {
+    int m;
+
+    aggregates->first_day = 0;
+    aggregates->last_day = -1;
+    aggregates->count = 0;
+    aggregates->model_count = model_count;
+    aggregates->model_price = malloc((model_count > 0 ? model_count : 1) * sizeof(double));
+    aggregates->model_margin = malloc((model_count > 0 ? model_count : 1) * sizeof(double));
+    aggregates->models = calloc(model_count > 0 ? model_count : 1, sizeof(struct ModelDays));
+    if (aggregates->model_price == NULL || aggregates->model_margin == NULL || aggregates->models == NULL) {
+        printf("Error! not enough memory for %d models\n", model_count);
+        exit(0);
+    }
+    for (m = 0; m < model_count; ++m) {
+        aggregates->model_price[m] = models[m].price;
+        aggregates->model_margin[m] = models[m].price - models[m].cost;
+    }
+    aggregates->days = allocate_days(1024);
+    allocate_trees(aggregates, 1024);
+}
+
+/**
+ * Releases the days and tree of every model.
+ */
+static void free_models(struct DailyAggregates *aggregates) {
+    int m;
+
+    for (m = 0; m < aggregates->model_count; ++m) {
+        free(aggregates->models[m].days);
+        free(aggregates->models[m].quantity);
+        memset(&aggregates->models[m], 0, sizeof(struct ModelDays));
+    }
+}
+
+/**
+ * Replaces the days and trees with saved ones, for instance the ones of a snapshot. The trees are copied as they
+ * are, so nothing is rebuilt.
+ * @param aggregates Pointer reference to DailyAggregates struct prepared by daily_aggregates_init.
+ * @param count Number of days which have orders.
+ * @param days Days which have orders, increasing.
+ * @param revenue Fenwick tree of the revenue, count + 1 entries.
+ * @param margin Fenwick tree of the margin, count + 1 entries.
+ * @param model_day_counts Number of days which have orders of each model.
+ * @param model_days Days of each model one after the other, increasing for each model.
+ * @param model_quantity Fenwick trees of the quantity of each model one after the other, model_day_counts + 1
+ * entries each.
+ */
+void daily_aggregates_load(struct DailyAggregates *aggregates, int count, const int *days, const double *revenue, const double *margin,
+                           const int *model_day_counts, const int *model_days, const long long *model_quantity) {
+    int m, capacity = count > 1024 ? count : 1024;
+
+    free(aggregates->days);
+    free(aggregates->revenue);
+    free(aggregates->margin);
+    free_models(aggregates);
+    aggregates->days = allocate_days(capacity);
+    allocate_trees(aggregates, capacity);
+    aggregates->count = count;
+    memcpy(aggregates->days, days, (size_t)count * sizeof(int));
+    memcpy(aggregates->revenue, revenue, ((size_t)count + 1) * sizeof(double));
+    memcpy(aggregates->margin, margin, ((size_t)count + 1) * sizeof(double));
+    aggregates->first_day = count > 0 ? days[0] : 0;
+    aggregates->last_day = count > 0 ? days[count - 1] : -1;
+
+    for (m = 0; m < aggregates->model_count; ++m) {
+        struct ModelDays *model = &aggregates->models[m];
+
+        if (model_day_counts[m] > 0) {
+            model_relayout(model, allocate_days(model_day_counts[m]), model_day_counts[m], model_day_counts[m]);
+            memcpy(model->days, model_days, (size_t)model->count * sizeof(int));
+            memcpy(model->quantity, model_quantity, ((size_t)model->count + 1) * sizeof(long long));
+            model_days += model->count;
+            model_quantity += model->count + 1;
+        }
+    }
+}
+
+/**
+ * Releases the aggregates.
+ * @param aggregates Pointer reference to the DailyAggregates struct.
+ */
+void daily_aggregates_free(struct DailyAggregates *aggregates) {
+    free_models(aggregates);
+    free(aggregates->models);
+    free(aggregates->days);
+    free(aggregates->revenue);
+    free(aggregates->margin);
+    free(aggregates->model_price);
+    free(aggregates->model_margin);
+}
+
+/**
+ * Gives the Fenwick index of a day in the revenue and margin trees, adding a zero bucket for it when it has no
+ * orders yet. A day after the latest one is appended in O(log days); another new day rebuilds the trees.
+ */
+static int bucket_of_day(struct DailyAggregates *aggregates, int day) {
+    int position = days_up_to(aggregates->days, aggregates->count, day), capacity, *days;
+
+    if (position > 0 && aggregates->days[position - 1] == day) {
+        return position;
+    }
+    if (position == aggregates->count && aggregates->count < aggregates->capacity) {
+        fenwick_append_double(aggregates->revenue, aggregates->count);
+        fenwick_append_double(aggregates->margin, aggregates->count);
+        aggregates->days[aggregates->count++] = day;
+        if (aggregates->count == 1) {
+            aggregates->first_day = day;
+        }
+        aggregates->last_day = day;
+        return aggregates->count;
+    }
+
+    capacity = aggregates->count < aggregates->capacity ? aggregates->capacity : aggregates->capacity * 2;
+    days = allocate_days(capacity);
+    merge_days(aggregates->days, aggregates->count, &day, 1, days);
+    fenwick_raw_double(aggregates->revenue, aggregates->count);
+    fenwick_raw_double(aggregates->margin, aggregates->count);
+    relayout(aggregates, days, aggregates->count + 1, capacity);
+    fenwick_build_double(aggregates->revenue, aggregates->count);
+    fenwick_build_double(aggregates->margin, aggregates->count);
+    return position + 1;
+}
+
+/**
+ * Gives the Fenwick index of a day in the tree of a model, as bucket_of_day does. The tree of a model is allocated
+ * with its first order.
+ */
+static int model_bucket_of_day(struct ModelDays *model, int day) {
+    int position = model->count > 0 ? days_up_to(model->days, model->count, day) : 0, capacity, *days;
+
+    if (position > 0 && model->days[position - 1] == day) {
+        return position;
+    }
+    if (position == model->count && model->count < model->capacity) {
+        fenwick_append_long(model->quantity, model->count);
+        model->days[model->count++] = day;
+        return model->count;
+    }
+
+    capacity = model->count < model->capacity ? model->capacity : (model->capacity > 0 ? model->capacity * 2 : 16);
+    days = allocate_days(capacity);
+    merge_days(model->days, model->count, &day, 1, days);
+    fenwick_raw_long(model->quantity, model->count);
+    model_relayout(model, days, model->count + 1, capacity);
+    fenwick_build_long(model->quantity, model->count);
+    return position + 1;
+}
+
+/**
+ * Tells whether an order of the given day can be added one at a time, that is whether it does not widen the span of
+ * the days by more than DAILY_AGGREGATES_MAX_DAYS. A whole history loaded by daily_aggregates_build has no limit.
+ * @param aggregates Pointer reference to the DailyAggregates struct.
+ * @param day Day of the order.
+ * @return Returns true if daily_aggregates_add accepts the day.
+ */
+bool daily_aggregates_holds(struct DailyAggregates *aggregates, int day) {
+    return aggregates->count == 0 || ((long long)day >= (long long)aggregates->first_day - DAILY_AGGREGATES_MAX_DAYS
+                                      && (long long)day <= (long long)aggregates->last_day + DAILY_AGGREGATES_MAX_DAYS);
+}
+
+/**
+ * Adds an order to the bucket of its day.
+ * @param aggregates Pointer reference to the DailyAggregates struct.
+ * @param day Day of the order.
+ * @param model_id Position of the model in the models array, unknown models are ignored.
+ * @param quantity Quantity ordered.
+ * @return Returns 0 on success, -1 if the day is too far from the other days (see daily_aggregates_holds), leaving
+ * the aggregates as they were.
+ */
+int daily_aggregates_add(struct DailyAggregates *aggregates, int day, int model_id, int quantity) {
+    struct ModelDays *model;
+    int i;
+
+    if (model_id < 0 || model_id >= aggregates->model_count) {
+        return 0;
+    }
+    if (!daily_aggregates_holds(aggregates, day)) {
+        return -1;
+    }
+
+    for (i = bucket_of_day(aggregates, day); i <= aggregates->count; i += low_bit(i)) {
+        aggregates->revenue[i] += aggregates->model_price[model_id] * quantity;
+        aggregates->margin[i] += aggregates->model_margin[model_id] * quantity;
+    }
+    model = &aggregates->models[model_id];
+    for (i = model_bucket_of_day(model, day); i <= model->count; i += low_bit(i)) {
+        model->quantity[i] += quantity;
+    }
+    return 0;
+}
+
+/**
+ * Compares two days, for qsort.
+ */
+static int compare_days(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Tells whether an order of the columns is of a model of the catalog.
+ */
+static bool known_model(struct DailyAggregates *aggregates, struct OrderColumns *columns, int i) {
+    return columns->model_id[i] >= 0 && columns->model_id[i] < aggregates->model_count;
+}
+
+/**
+ * Lists the distinct days of the orders of the columns known to the catalog, increasing, and tells whether the
+ * columns are sorted by day, as they are once loaded. Sorted orders are listed in one pass; others are sorted first.
+ * @return Returns the number of days.
+ */
+static int distinct_days(struct DailyAggregates *aggregates, struct OrderColumns *columns, int **days, bool *sorted) {
+    int i, count = 0, previous = 0;
+
+    *sorted = true;
+    for (i = 1; i < columns->count && *sorted; ++i) {
+        *sorted = columns->timestamp[i - 1] <= columns->timestamp[i];
+    }
+    *days = allocate_days(columns->count);
+    for (i = 0; i < columns->count; ++i) {
+        if (known_model(aggregates, columns, i) && (count == 0 || !*sorted || columns->timestamp[i] != previous)) {
+            (*days)[count++] = previous = columns->timestamp[i];
+        }
+    }
+    if (!*sorted) {
+        int unique = 0;
+
+        qsort(*days, count, sizeof(int), compare_days);
+        for (i = 0; i < count; ++i) {
+            if (unique == 0 || (*days)[i] != (*days)[unique - 1]) {
+                (*days)[unique++] = (*days)[i];
+            }
+        }
+        count = unique;
+    }
+    return count;
+}
+
+/**
+ * Lists the orders of the columns known to the catalog by day, with a counting sort over the days of the aggregates,
+ * for columns which are not sorted by day.
+ * @return Returns the positions of the orders, to free.
+ */
+static int *orders_by_day(struct DailyAggregates *aggregates, struct OrderColumns *columns) {
+    int i, *starts = calloc((size_t)aggregates->count + 1, sizeof(int)), *positions = malloc((columns->count > 0 ? columns->count : 1) * sizeof(int));
+
+    if (starts == NULL || positions == NULL) {
+        printf("Error! not enough memory for %d orders\n", columns->count);
+        exit(0);
+    }
+    for (i = 0; i < columns->count; ++i) {
+        if (known_model(aggregates, columns, i)) {
+            starts[days_up_to(aggregates->days, aggregates->count, columns->timestamp[i])]++;
+        }
+    }
+    for (i = 1; i <= aggregates->count; ++i) {
+        starts[i] += starts[i - 1];
+    }
+    for (i = columns->count - 1; i >= 0; --i) {
+        if (known_model(aggregates, columns, i)) {
+            positions[--starts[days_up_to(aggregates->days, aggregates->count, columns->timestamp[i])]] = i;
+        }
+    }
+    free(starts);
+    return positions;
+}
+
+/**
+ * Adds the quantities of the orders of the columns to the tree of each model. The orders are read by day, so the
+ * distinct days of each model are counted and listed in two passes, merged with the days the model already has and
+ * filled with raw values through a cursor per model. Only the models which have orders get a tree, sized to their
+ * days.
+ * @param aggregates Pointer reference to the DailyAggregates struct.
+ * @param columns Pointer reference to the OrderColumns struct.
+ * @param positions Positions of the known orders by day, NULL when the columns are sorted by day.
+ * @param ordered Number of positions.
+ */
+static void build_models(struct DailyAggregates *aggregates, struct OrderColumns *columns, const int *positions, int ordered) {
+    int i, m, model_count = aggregates->model_count > 0 ? aggregates->model_count : 1;
+    int *counts = calloc(model_count, sizeof(int)), *last = malloc(model_count * sizeof(int));
+    int **added = calloc(model_count, sizeof(int *));
+
+    if (counts == NULL || last == NULL || added == NULL) {
+        printf("Error! not enough memory for %d models\n", aggregates->model_count);
+        exit(0);
+    }
+    for (i = 0; i < ordered; ++i) {
+        int order = positions != NULL ? positions[i] : i;
+
+        if (positions != NULL || known_model(aggregates, columns, order)) {
+            m = columns->model_id[order];
+            if (counts[m] == 0 || last[m] != columns->timestamp[order]) {
+                last[m] = columns->timestamp[order];
+                counts[m]++;
+            }
+        }
+    }
+    for (m = 0; m < aggregates->model_count; ++m) {
+        added[m] = counts[m] > 0 ? allocate_days(counts[m]) : NULL;
+        counts[m] = 0;
+    }
+    for (i = 0; i < ordered; ++i) {
+        int order = positions != NULL ? positions[i] : i;
+
+        if (positions != NULL || known_model(aggregates, columns, order)) {
+            m = columns->model_id[order];
+            if (counts[m] == 0 || added[m][counts[m] - 1] != columns->timestamp[order]) {
+                added[m][counts[m]++] = columns->timestamp[order];
+            }
+        }
+    }
+    for (m = 0; m < aggregates->model_count; ++m) {
+        struct ModelDays *model = &aggregates->models[m];
+        int *days;
+
+        if (counts[m] == 0) {
+            continue;
+        }
+        days = allocate_days(model->count + counts[m]);
+        i = merge_days(model->days, model->count, added[m], counts[m], days);
+        fenwick_raw_long(model->quantity, model->count);
+        model_relayout(model, days, i, model->count + counts[m]);
+        free(added[m]);
+        last[m] = 0;
+    }
+    for (i = 0; i < ordered; ++i) {
+        int order = positions != NULL ? positions[i] : i;
+        struct ModelDays *model;
+
+        if (positions == NULL && !known_model(aggregates, columns, order)) {
+            continue;
+        }
+        m = columns->model_id[order];
+        model = &aggregates->models[m];
+        while (model->days[last[m]] != columns->timestamp[order]) {
+            last[m]++;
+        }
+        model->quantity[last[m] + 1] += columns->quantity[order];
+    }
+    for (m = 0; m < aggregates->model_count; ++m) {
+        if (counts[m] > 0) {
+            fenwick_build_long(aggregates->models[m].quantity, aggregates->models[m].count);
+        }
+    }
+    free(counts);
+    free(last);
+    free(added);
+}
+
+/**
+ * Adds every order of the columns. The buckets are filled with raw values in one pass and the trees are built
+ * once at the end, so loading a whole history sorted by day costs O(orders + days). However far apart the days,
+ * only the days which have orders take room, and only the models which have orders get a tree.
+ * @param aggregates Pointer reference to the DailyAggregates struct.
+ * @param columns Pointer reference to the OrderColumns struct.
+ */
+void daily_aggregates_build(struct DailyAggregates *aggregates, struct OrderColumns *columns) {
+    int i, k, count, bucket = 0, previous = 0, ordered, *added, *days, *positions = NULL;
+    bool sorted;
+
+    count = distinct_days(aggregates, columns, &added, &sorted);
+    if (count == 0) {
+        free(added);
+        return;
+    }
+    days = allocate_days(aggregates->count + count);
+    k = merge_days(aggregates->days, aggregates->count, added, count, days);
+    free(added);
+    fenwick_raw_double(aggregates->revenue, aggregates->count);
+    fenwick_raw_double(aggregates->margin, aggregates->count);
+    relayout(aggregates, days, k, k);
+
+    ordered = columns->count;
+    for (i = 0; i < columns->count; ++i) {
+        int model_id = columns->model_id[i];
+
+        if (!known_model(aggregates, columns, i)) {
+            ordered--;
+            continue;
+        }
+        if (bucket == 0 || columns->timestamp[i] != previous) {
+            previous = columns->timestamp[i];
+            bucket = days_up_to(aggregates->days, aggregates->count, previous);
+        }
+        aggregates->revenue[bucket] += aggregates->model_price[model_id] * columns->quantity[i];
+        aggregates->margin[bucket] += aggregates->model_margin[model_id] * columns->quantity[i];
+    }
+    fenwick_build_double(aggregates->revenue, aggregates->count);
+    fenwick_build_double(aggregates->margin, aggregates->count);
+
+    if (!sorted) {
+        positions = orders_by_day(aggregates, columns);
+    }
+    build_models(aggregates, columns, positions, sorted ? columns->count : ordered);
+    free(positions);
+}
+
+/**
+ * Gives the revenue and margin of the orders placed from day from to day to, both included.
+ * @param aggregates Pointer reference to the DailyAggregates struct.
+ * @param from First day of the range.
+ * @param to Last day of the range.
+ * @param revenue Receives the revenue.
+ * @param margin Receives the margin (sale - cost).
+ */
+void daily_aggregates_range(struct DailyAggregates *aggregates, int from, int to, double *revenue, double *margin) {
+    int high = days_up_to(aggregates->days, aggregates->count, to), low = days_up_to(aggregates->days, aggregates->count, (long long)from - 1);
+
+    if (to < from) {
+        *revenue = 0;
+        *margin = 0;
+        return;
+    }
+    *revenue = fenwick_prefix_double(aggregates->revenue, high) - fenwick_prefix_double(aggregates->revenue, low);
+    *margin = fenwick_prefix_double(aggregates->margin, high) - fenwick_prefix_double(aggregates->margin, low);
+}
+
+/**
+ * Gives the quantity of one model ordered from day from to day to, both included.
+ * @param aggregates Pointer reference to the DailyAggregates struct.
+ * @param model_id Position of the model in the models array.
+ * @param from First day of the range.
+ * @param to Last day of the range.
+ * @return Returns the quantity ordered.
+ */
+long long daily_aggregates_model_quantity(struct DailyAggregates *aggregates, int model_id, int from, int to) {
+    struct ModelDays *model;
+
+    if (to < from || model_id < 0 || model_id >= aggregates->model_count) {
+        return 0;
+    }
+    model = &aggregates->models[model_id];
+    return fenwick_prefix_long(model->quantity, days_up_to(model->days, model->count, to))
+           - fenwick_prefix_long(model->quantity, days_up_to(model->days, model->count, (long long)from - 1));
+}
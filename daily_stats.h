@@ -0,0 +1,52 @@
+#ifndef ORDER_SYSTEM_DAILY_STATS_H
+#define ORDER_SYSTEM_DAILY_STATS_H
+#include <stdio.h>
+#include <stdbool.h>
+#include "order_system.h"
+#include "order_store.h"
+#define DAILY_AGGREGATES_MAX_DAYS (1 << 22)
+/** @file */
+
+/**
+ * Quantity of one model ordered each day, kept in a Fenwick tree over the days which have orders of the model.
+ */
+struct ModelDays {
+    int *days; /**< Days which have orders of the model, increasing, NULL until the model has an order. */
+    long long *quantity; /**< Fenwick tree of the quantity ordered each day, capacity + 1 entries. */
+    int count; /**< Number of days which have orders of the model. */
+    int capacity; /**< Number of days the tree has room for. */
+};
+
+/**
+ * Revenue, margin and per-model quantity per day, kept in Fenwick trees over the days which have orders: bucket i + 1
+ * of the revenue and margin trees is the day days[i], and each model has its own days (see ModelDays). Memory grows
+ * with the days which have orders and the (model, day) pairs which have orders, not with the span of the history or
+ * the size of the catalog.
+ * Adding an order on a known day or after the latest one and summing any range of days both take O(log days); an
+ * order on a new day before the latest one costs a rebuild. A single order may not widen the span of the days by
+ * more than DAILY_AGGREGATES_MAX_DAYS, about eleven thousand years, which catches mistyped days.
+ */
+struct DailyAggregates {
+    int *days; /**< Days which have orders, increasing. */
+    int count; /**< Number of days which have orders. */
+    int capacity; /**< Number of days the trees have room for. */
+    int first_day; /**< Earliest day with an order. */
+    int last_day; /**< Latest day with an order, first_day - 1 while empty. */
+    int model_count; /**< Number of models. */
+    double *revenue; /**< Fenwick tree of the revenue of each day, capacity + 1 entries. */
+    double *margin; /**< Fenwick tree of the margin (sale - cost) of each day, capacity + 1 entries. */
+    struct ModelDays *models; /**< Quantity of each model per day. */
+    double *model_price; /**< Sale price of each model. */
+    double *model_margin; /**< Margin of one item of each model. */
+};
+
+void daily_aggregates_init(struct DailyAggregates *, struct ModelInfo *, int);
+void daily_aggregates_load(struct DailyAggregates *, int, const int *, const double *, const double *, const int *, const int *, const long long *);
+void daily_aggregates_free(struct DailyAggregates *);
+bool daily_aggregates_holds(struct DailyAggregates *, int);
+int daily_aggregates_add(struct DailyAggregates *, int, int, int);
+void daily_aggregates_build(struct DailyAggregates *, struct OrderColumns *);
+void daily_aggregates_range(struct DailyAggregates *, int, int, double *, double *);
+long long daily_aggregates_model_quantity(struct DailyAggregates *, int, int, int);
+
+#endif //ORDER_SYSTEM_DAILY_STATS_H
@@ -0,0 +1,164 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include "event_log.h"
+
+/**
+ * Body of the writer thread: writes every record published by the producer, in contiguous batches, and sleeps
+ * briefly when the ring is empty.
+ */
+static void *event_log_writer(void *argument) {
+    struct EventLog *log = argument;
+    struct timespec pause = {0, 100000};
+
+    for (;;) {
+        uint64_t tail = atomic_load_explicit(&log->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&log->head, memory_order_acquire);
+
+        if (head == tail) {
+            if (atomic_load_explicit(&log->closing, memory_order_acquire)
+                && atomic_load_explicit(&log->head, memory_order_acquire) == tail) {
+                return NULL;
+            }
+            nanosleep(&pause, NULL);
+            continue;
+        }
+        while (tail != head) {
+            size_t first = (size_t)(tail % EVENT_LOG_RING_SIZE);
+            size_t count = (size_t)(head - tail);
+
+            if (count > EVENT_LOG_RING_SIZE - first) {
+                count = EVENT_LOG_RING_SIZE - first;
+            }
+            if (!log->failed && fwrite(log->ring + first, sizeof(struct EventRecord), count, log->fptr) != count) {
+                log->failed = true;
+            }
+            tail += count;
+        }
+        atomic_store_explicit(&log->tail, tail, memory_order_release);
+    }
+}
+
+/**
+ * Creates an event log file and starts its writer thread.
+ * @param log Pointer reference to the EventLog struct.
+ * @param name File name
+ * @return Returns 0 on success, -1 if the file could not be created.
+ */
+int event_log_open(struct EventLog *log, char *name) {
+    struct EventLogHeader header;
+
+    memset(log, 0, sizeof(*log));
+    log->ring = malloc(EVENT_LOG_RING_SIZE * sizeof(struct EventRecord));
+    if (log->ring == NULL) {
+        printf("Error! not enough memory for the event log\n");
+        exit(0);
+    }
+    if ((log->fptr = fopen(name, "wb")) == NULL) {
+        printf("Error! opening file %s\n", name);
+        free(log->ring);
+        return -1;
+    }
+    setvbuf(log->fptr, NULL, _IOFBF, 1 << 20);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC));
+    header.version = EVENT_LOG_VERSION;
+    header.record_size = sizeof(struct EventRecord);
+    if (fwrite(&header, sizeof(header), 1, log->fptr) != 1) {
+        log->failed = true;
+    }
+
+    atomic_init(&log->head, 0);
+    atomic_init(&log->tail, 0);
+    atomic_init(&log->closing, false);
+    if (pthread_create(&log->writer, NULL, event_log_writer, log) != 0) {
+        printf("Error! starting the event log writer\n");
+        exit(0);
+    }
+    return 0;
+}
+
+/**
+ * Adds an event to the log. Only the simulation thread may call it.
+ * @param log Pointer reference to the EventLog struct.
+ * @param type EventType of the event.
+ * @param model_id Id of the model concerned, -1 if none.
+ * @param time Hour or day of the event.
+ * @param order Position of the order in the orders array, -1 if none.
+ * @param quantity Items concerned.
+ * @param customer_id Id of the customer of the order, -1 if none.
+ */
+void event_log_push(struct EventLog *log, int type, int model_id, int time, int order, int quantity, int customer_id) {
+    uint64_t head = atomic_load_explicit(&log->head, memory_order_relaxed);
+    struct EventRecord *record;
+
+    if (head - log->cached_tail == EVENT_LOG_RING_SIZE) {
+        log->cached_tail = atomic_load_explicit(&log->tail, memory_order_acquire);
+        if (head - log->cached_tail == EVENT_LOG_RING_SIZE) {
+            log->stalls++;
+            while (head - (log->cached_tail = atomic_load_explicit(&log->tail, memory_order_acquire)) == EVENT_LOG_RING_SIZE) {
+                sched_yield();
+            }
+        }
+    }
+
+    record = log->ring + head % EVENT_LOG_RING_SIZE;
+    record->type = (uint8_t)type;
+    memset(record->reserved, 0, sizeof(record->reserved));
+    record->model_id = model_id;
+    record->time = time;
+    record->order = order;
+    record->quantity = quantity;
+    record->customer_id = customer_id;
+    atomic_store_explicit(&log->head, head + 1, memory_order_release);
+}
+
+/**
+ * Waits for the writer thread to drain the ring, then writes the customer and model names and the footer and
+ * closes the file.
+ * @param log Pointer reference to the EventLog struct.
+ * @param customers Pointer reference to the customer InternTable the customer ids refer to.
+ * @param catalog Pointer reference to the ModelCatalog the model ids refer to.
+ * @return Returns 0 on success, -1 if the file could not be written.
+ */
+int event_log_close(struct EventLog *log, struct InternTable *customers, struct ModelCatalog *catalog) {
+    struct EventLogFooter footer;
+    int i, status = 0;
+
+    atomic_store_explicit(&log->closing, true, memory_order_release);
+    pthread_join(log->writer, NULL);
+
+    memset(&footer, 0, sizeof(footer));
+    footer.record_count = atomic_load(&log->head);
+    footer.customer_names_offset = sizeof(struct EventLogHeader) + footer.record_count * sizeof(struct EventRecord);
+    footer.customer_names_size = customers->arena_length;
+    footer.customer_count = customers->count;
+    footer.model_names_offset = footer.customer_names_offset + customers->count * sizeof(uint64_t) + customers->arena_length;
+    footer.model_count = catalog->count;
+    memcpy(footer.magic, EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC));
+
+    for (i = 0; i < customers->count; ++i) {
+        uint64_t offset = customers->offsets[i];
+        status |= fwrite(&offset, sizeof(offset), 1, log->fptr) == 1 ? 0 : -1;
+    }
+    if (customers->arena_length > 0 && fwrite(customers->arena, 1, customers->arena_length, log->fptr) != customers->arena_length) {
+        status = -1;
+    }
+    for (i = 0; i < catalog->count; ++i) {
+        status |= fwrite(catalog->models[i].model, MODEL_NAME_LENGTH, 1, log->fptr) == 1 ? 0 : -1;
+    }
+    status |= fwrite(&footer, sizeof(footer), 1, log->fptr) == 1 ? 0 : -1;
+    if (fclose(log->fptr) != 0 || log->failed) {
+        status = -1;
+    }
+    if (status != 0) {
+        printf("Error! writing the event log\n");
+    }
+    free(log->ring);
+    log->ring = NULL;
+    return status;
+}
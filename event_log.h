@@ -0,0 +1,86 @@
+#ifndef ORDER_SYSTEM_EVENT_LOG_H
+#define ORDER_SYSTEM_EVENT_LOG_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "intern_table.h"
+#include "order_system.h"
+#define EVENT_LOG_MAGIC "COFFEVT"
+#define EVENT_LOG_VERSION 3
+#define EVENT_LOG_RING_SIZE 65536
+/** @file */
+
+/**
+ * Kind of a simulation event.
+ */
+enum EventType {
+    EVENT_ORDER_STARTED = 1, /**< An order started processing, time is the hour. */
+    EVENT_ORDER_COMPLETED, /**< An order was completed, time is the hour. */
+    EVENT_ORDERS_WAITING, /**< Orders are left waiting for workers, quantity is how many, time is the hour. */
+    EVENT_IDLE_DAYS, /**< No order was placed on a range of days, time is the first day and quantity the number of days. */
+    EVENT_ITEMS_STOCKED, /**< Items of a model were made for the stock over idle days, time is the first day. */
+    EVENT_SOLD_FROM_STOCK, /**< An order was served from the stock, time is the order timestamp. */
+    EVENT_UNKNOWN_MODEL /**< An order of an unknown model was skipped, time is the order timestamp. */
+};
+
+/**
+ * Fixed size record of one event, as stored in the ring and in the file.
+ */
+struct EventRecord {
+    uint8_t type; /**< EventType of the event. */
+    uint8_t reserved[3]; /**< Unused, always zero. */
+    int32_t model_id; /**< Id of the model concerned, -1 if none. */
+    int32_t time; /**< Hour or day of the event, see EventType. */
+    int32_t order; /**< Position of the order in the orders array, -1 if none. */
+    int32_t quantity; /**< Items concerned. */
+    int32_t customer_id; /**< Id of the customer of the order, -1 if none. */
+};
+
+/**
+ * Header at the start of an event log file, followed by the records.
+ */
+struct EventLogHeader {
+    char magic[8]; /**< EVENT_LOG_MAGIC, null terminated. */
+    uint32_t version; /**< EVENT_LOG_VERSION. */
+    uint32_t record_size; /**< Size of one EventRecord. */
+};
+
+/**
+ * Footer at the end of an event log file. The customer string table (offset array followed by the null terminated
+ * names) and the model names (MODEL_NAME_LENGTH bytes each) sit between the last record and the footer, so that
+ * events can name customers and models by id.
+ */
+struct EventLogFooter {
+    uint64_t record_count; /**< Number of records after the header. */
+    uint64_t model_names_offset; /**< Offset of the model names. */
+    int64_t model_count; /**< Number of model names. */
+    uint64_t customer_names_offset; /**< Offset of the customer string table. */
+    uint64_t customer_names_size; /**< Size in bytes of the null terminated names. */
+    int64_t customer_count; /**< Number of entries of the customer string table. */
+    char magic[8]; /**< EVENT_LOG_MAGIC again, to detect truncated files. */
+};
+
+/**
+ * Event journal. The simulation thread pushes records into a single producer, single consumer ring without locks
+ * and a background thread drains the ring to the file in batches, so the simulation never waits on the output
+ * unless the writer falls a whole ring behind.
+ */
+struct EventLog {
+    struct EventRecord *ring; /**< Ring of EVENT_LOG_RING_SIZE records. */
+    _Atomic uint64_t head; /**< Records pushed so far, written by the producer only. */
+    _Atomic uint64_t tail; /**< Records written so far, written by the writer thread only. */
+    uint64_t cached_tail; /**< Producer copy of tail, refreshed only when the ring looks full. */
+    _Atomic bool closing; /**< Tells the writer thread to stop once the ring is empty. */
+    bool failed; /**< Set by the writer thread if the file could not be written. */
+    uint64_t stalls; /**< Times the producer found the ring full and had to wait. */
+    FILE *fptr; /**< File receiving the records. */
+    pthread_t writer; /**< Background writer thread. */
+};
+
+int event_log_open(struct EventLog *, char *);
+void event_log_push(struct EventLog *, int, int, int, int, int, int);
+int event_log_close(struct EventLog *, struct InternTable *, struct ModelCatalog *);
+
+#endif //ORDER_SYSTEM_EVENT_LOG_H
@@ -0,0 +1,149 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "event_log.h"
+
+#define RENDER_BATCH 4096
+
+/**
+ * Customer and model names of an event log.
+ */
+struct EventNames {
+    struct EventLogFooter footer; /**< Footer of the log. */
+    uint64_t *offsets; /**< Offset of each customer name in names. */
+    char *names; /**< Null terminated customer names. */
+    char *model_names; /**< Model names, MODEL_NAME_LENGTH bytes each. */
+};
+
+/**
+ * Name of a customer of the event log, "?" for an unknown id.
+ */
+static const char *customer_name(struct EventNames *names, int customer_id) {
+    if (customer_id < 0 || customer_id >= names->footer.customer_count || names->offsets[customer_id] >= names->footer.customer_names_size) {
+        return "?";
+    }
+    return names->names + names->offsets[customer_id];
+}
+
+/**
+ * Name of a model of the event log, "?" for an unknown id.
+ */
+static const char *model_name(struct EventNames *names, int model_id) {
+    if (model_id < 0 || model_id >= names->footer.model_count) {
+        return "?";
+    }
+    return names->model_names + (size_t)model_id * MODEL_NAME_LENGTH;
+}
+
+/**
+ * Prints one event as the text the simulation prints on the console.
+ */
+static void render_event(FILE *out, struct EventRecord *record, struct EventNames *names) {
+    const char *name = customer_name(names, record->customer_id);
+    const char *model = model_name(names, record->model_id);
+
+    switch (record->type) {
+        case EVENT_ORDER_STARTED:
+            fprintf(out, "Started processing order of %d items of  Model %s by %s at %d\n", record->quantity, model, name, record->time);
+            break;
+        case EVENT_ORDER_COMPLETED:
+            fprintf(out, "Completed Order of %d items of  Model %s by %s at %d\n", record->quantity, model, name, record->time);
+            break;
+        case EVENT_ORDERS_WAITING:
+            fprintf(out, "Not enough workers available, waiting\n");
+            break;
+        case EVENT_IDLE_DAYS:
+            if (record->quantity <= 1) {
+                fprintf(out, "No orders placed on %d\n", record->time);
+            } else {
+                fprintf(out, "No orders placed from %d to %lld\n", record->time, (long long)record->time + record->quantity - 1);
+            }
+            fprintf(out, "Prepare models for storing in stock\n");
+            break;
+        case EVENT_ITEMS_STOCKED:
+            fprintf(out, "Stocked %d items of Model %s on %d\n", record->quantity, model, record->time);
+            break;
+        case EVENT_SOLD_FROM_STOCK:
+            fprintf(out, "Sold order of %d items of  Model %s by %s from stock\n", record->quantity, model, name);
+            break;
+        case EVENT_UNKNOWN_MODEL:
+            fprintf(out, "Unknown model in order of %s, skipping\n", name);
+            break;
+        default:
+            fprintf(out, "Unknown event %d\n", record->type);
+            break;
+    }
+}
+
+/**
+ * Prints an event log written by ./main --events as human readable text.
+ * Usage: ./event_render events.bin
+ * @return Return 0 if the whole log was rendered.
+ */
+int main(int argc, char **argv) {
+    FILE *fptr;
+    struct EventLogHeader header;
+    struct EventNames names;
+    struct EventLogFooter footer;
+    struct EventRecord *records;
+    uint64_t done = 0;
+
+    if (argc != 2) {
+        printf("Usage: %s events.bin\n", argv[0]);
+        return 1;
+    }
+    if ((fptr = fopen(argv[1], "rb")) == NULL) {
+        printf("Error! opening file %s\n", argv[1]);
+        return 1;
+    }
+    if (fread(&header, sizeof(header), 1, fptr) != 1 || memcmp(header.magic, EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC)) != 0
+        || header.version != EVENT_LOG_VERSION || header.record_size != sizeof(struct EventRecord)
+        || fseek(fptr, -(long)sizeof(footer), SEEK_END) != 0 || fread(&footer, sizeof(footer), 1, fptr) != 1
+        || memcmp(footer.magic, EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC)) != 0 || footer.customer_count < 0 || footer.model_count < 0
+        || footer.customer_names_offset != sizeof(header) + footer.record_count * sizeof(struct EventRecord)
+        || footer.model_names_offset != footer.customer_names_offset + footer.customer_count * sizeof(uint64_t) + footer.customer_names_size) {
+        printf("Error! %s is not a complete event log\n", argv[1]);
+        fclose(fptr);
+        return 1;
+    }
+
+    names.footer = footer;
+    names.offsets = malloc((footer.customer_count > 0 ? footer.customer_count : 1) * sizeof(uint64_t));
+    names.names = malloc(footer.customer_names_size + 1);
+    names.model_names = malloc((footer.model_count > 0 ? footer.model_count : 1) * MODEL_NAME_LENGTH);
+    records = malloc(RENDER_BATCH * sizeof(struct EventRecord));
+    if (names.offsets == NULL || names.names == NULL || names.model_names == NULL || records == NULL) {
+        printf("Error! not enough memory for the event log\n");
+        exit(0);
+    }
+    names.names[footer.customer_names_size] = '\0';
+    if (fseek(fptr, (long)footer.customer_names_offset, SEEK_SET) != 0
+        || fread(names.offsets, sizeof(uint64_t), (size_t)footer.customer_count, fptr) != (size_t)footer.customer_count
+        || fread(names.names, 1, footer.customer_names_size, fptr) != footer.customer_names_size
+        || fread(names.model_names, MODEL_NAME_LENGTH, (size_t)footer.model_count, fptr) != (size_t)footer.model_count
+        || fseek(fptr, (long)sizeof(header), SEEK_SET) != 0) {
+        printf("Error! reading file %s\n", argv[1]);
+        return 1;
+    }
+
+    while (done < footer.record_count) {
+        size_t i, count = footer.record_count - done < RENDER_BATCH ? (size_t)(footer.record_count - done) : RENDER_BATCH;
+
+        if (fread(records, sizeof(struct EventRecord), count, fptr) != count) {
+            printf("Error! reading file %s\n", argv[1]);
+            return 1;
+        }
+        for (i = 0; i < count; ++i) {
+            render_event(stdout, &records[i], &names);
+        }
+        done += count;
+    }
+
+    fclose(fptr);
+    free(names.offsets);
+    free(names.names);
+    free(names.model_names);
+    free(records);
+    return 0;
+}
@@ -0,0 +1,177 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "intern_table.h"
+
+/**
+ * Prepares an empty table.
+ * @param table Pointer reference to the InternTable struct.
+ */
+void intern_table_init(struct InternTable *table) {
+    int i;
+
+    table->arena_capacity = 4096;
+    table->arena_length = 0;
+    table->arena = malloc(table->arena_capacity);
+    table->ids_capacity = 256;
+    table->count = 0;
+    table->offsets = malloc(table->ids_capacity * sizeof(size_t));
+    table->hashes = malloc(table->ids_capacity * sizeof(uint32_t));
+    table->slots_size = 512;
+    table->slots = malloc(table->slots_size * sizeof(int));
+
+    if (table->arena == NULL || table->offsets == NULL || table->hashes == NULL || table->slots == NULL) {
+        printf("Error! not enough memory for the name table\n");
+        exit(0);
+    }
+    for (i = 0; i < table->slots_size; ++i) {
+        table->slots[i] = -1;
+    }
+}
+
+/**
+ * Releases the memory of the table.
+ * @param table Pointer reference to the InternTable struct.
+ */
+void intern_table_free(struct InternTable *table) {
+    free(table->arena);
+    free(table->offsets);
+    free(table->hashes);
+    free(table->slots);
+    table->arena = NULL;
+    table->offsets = NULL;
+    table->hashes = NULL;
+    table->slots = NULL;
+}
+
+/**
+ * FNV-1a hash of the name.
+ */
+static uint32_t hash_name(const char *name, size_t length) {
+    uint32_t hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < length; ++i) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Finds the slot holding the name, or the empty slot where it should be inserted.
+ */
+static int find_slot(struct InternTable *table, const char *name, size_t length, uint32_t hash) {
+    int mask = table->slots_size - 1;
+    int slot = (int)(hash & (uint32_t)mask);
+
+    for (;;) {
+        int id = table->slots[slot];
+        if (id < 0) {
+            return slot;
+        }
+        if (table->hashes[id] == hash) {
+            const char *other = table->arena + table->offsets[id];
+            if (strncmp(other, name, length) == 0 && other[length] == '\0') {
+                return slot;
+            }
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+/**
+ * Doubles the number of hash slots and reinserts every id.
+ */
+static void grow_slots(struct InternTable *table) {
+    int i, slot, mask;
+
+    free(table->slots);
+    table->slots_size *= 2;
+    table->slots = malloc(table->slots_size * sizeof(int));
+    if (table->slots == NULL) {
+        printf("Error! not enough memory for the name table\n");
+        exit(0);
+    }
+    for (i = 0; i < table->slots_size; ++i) {
+        table->slots[i] = -1;
+    }
+
+    mask = table->slots_size - 1;
+    for (i = 0; i < table->count; ++i) {
+        slot = (int)(table->hashes[i] & (uint32_t)mask);
+        while (table->slots[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+        table->slots[slot] = i;
+    }
+}
+
+/**
+ * Gives the id of the name, assigning the next free id if the name was never seen before.
+ * @param table Pointer reference to the InternTable struct.
+ * @param name Name to look up, not necessarily null terminated.
+ * @param length Length of the name.
+ * @return Returns the id of the name.
+ */
+int intern_table_id(struct InternTable *table, const char *name, size_t length) {
+    uint32_t hash = hash_name(name, length);
+    int slot = find_slot(table, name, length, hash);
+    int id;
+
+    if (table->slots[slot] >= 0) {
+        return table->slots[slot];
+    }
+
+    if (table->arena_length + length + 1 > table->arena_capacity) {
+        while (table->arena_length + length + 1 > table->arena_capacity) {
+            table->arena_capacity *= 2;
+        }
+        table->arena = realloc(table->arena, table->arena_capacity);
+    }
+    if (table->count == table->ids_capacity) {
+        table->ids_capacity *= 2;
+        table->offsets = realloc(table->offsets, table->ids_capacity * sizeof(size_t));
+        table->hashes = realloc(table->hashes, table->ids_capacity * sizeof(uint32_t));
+    }
+    if (table->arena == NULL || table->offsets == NULL || table->hashes == NULL) {
+        printf("Error! not enough memory for the name table\n");
+        exit(0);
+    }
+
+    id = table->count++;
+    memcpy(table->arena + table->arena_length, name, length);
+    table->arena[table->arena_length + length] = '\0';
+    table->offsets[id] = table->arena_length;
+    table->hashes[id] = hash;
+    table->arena_length += length + 1;
+    table->slots[slot] = id;
+
+    /* Keep the load factor under one half so that probe sequences stay short. */
+    if (2 * table->count > table->slots_size) {
+        grow_slots(table);
+    }
+    return id;
+}
+
+/**
+ * Gives the id of the name without adding it.
+ * @param table Pointer reference to the InternTable struct.
+ * @param name Name to look up, not necessarily null terminated.
+ * @param length Length of the name.
+ * @return Returns the id of the name, or -1 if the name is not in the table.
+ */
+int intern_table_find(struct InternTable *table, const char *name, size_t length) {
+    return table->slots[find_slot(table, name, length, hash_name(name, length))];
+}
+
+/**
+ * Gives the name associated with an id. The pointer stays valid until the next name is added.
+ * @param table Pointer reference to the InternTable struct.
+ * @param id Id of the name.
+ * @return Returns the null terminated name.
+ */
+const char *intern_table_name(struct InternTable *table, int id) {
+    return table->arena + table->offsets[id];
+}
@@ -0,0 +1,29 @@
+#ifndef ORDER_SYSTEM_INTERN_TABLE_H
+#define ORDER_SYSTEM_INTERN_TABLE_H
+#include <stddef.h>
+#include <stdint.h>
+/** @file */
+
+/**
+ * Maps names to dense integer ids (0, 1, 2, ... in order of first appearance).
+ * Names are copied once into a string arena and looked up through an open addressing hash table.
+ */
+struct InternTable {
+    char *arena; /**< Null terminated names, one after the other. */
+    size_t arena_length; /**< Bytes used in the arena. */
+    size_t arena_capacity; /**< Bytes allocated for the arena. */
+    size_t *offsets; /**< Offset in the arena of the name of each id. */
+    uint32_t *hashes; /**< Hash of the name of each id, kept to rehash without touching the arena. */
+    int count; /**< Number of ids assigned. */
+    int ids_capacity; /**< Allocated size of the offsets and hashes arrays. */
+    int *slots; /**< Hash slots holding an id, or -1 when empty. */
+    int slots_size; /**< Number of hash slots, always a power of two. */
+};
+
+void intern_table_init(struct InternTable *);
+void intern_table_free(struct InternTable *);
+int intern_table_id(struct InternTable *, const char *, size_t);
+int intern_table_find(struct InternTable *, const char *, size_t);
+const char *intern_table_name(struct InternTable *, int);
+
+#endif //ORDER_SYSTEM_INTERN_TABLE_H
@@ -3,465 +3,846 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <limits.h>
 #include "order_system.h"
+#include "order_reader.h"
+#include "order_sort.h"
+#include "scheduler.h"
+#include "order_store.h"
+#include "order_file.h"
+#include "daily_stats.h"
+#include "sweep.h"
+#include "stock.h"
+#include "metrics.h"
+#include "event_log.h"
+#include "order_server.h"
+#include "snapshot.h"
+#include "customer_stats.h"
+#include "order_manifest.h"
 
 /**
- * Reads the file of the name provided.
- * @param fptr pointer to the FILE object
- * @param name File name
+ * Holds the command line options of the program.
  */
+struct Options {
+    char *orders_file_name; /**< Orders file, text or binary, the first one when there are several. */
+    char **orders_file_names; /**< Orders files, several text files are merged by timestamp. */
+    int orders_file_count; /**< Number of orders files. */
+    char *sweep_grid_file_name; /**< Parameter grid of a capacity sweep, NULL for a normal run. */
+    char *sweep_output_file_name; /**< File receiving the table of the sweep. */
+    int threads; /**< Number of threads, 0 to use every core. */
+    enum SchedulePolicy policy; /**< Order in which waiting orders get the workers. */
+    bool policy_given; /**< Set when --policy is on the command line, so that it overrides the policy of a restored snapshot. */
+    char *metrics_file_name; /**< File receiving the simulation metrics, CSV if it ends in .csv and JSON otherwise. */
+    char *events_file_name; /**< File receiving the binary event log, NULL to skip it. */
+    bool quiet; /**< Skips the order table and the message printed for every order started and completed. */
+    char *serve_path; /**< Unix socket to serve on after loading the orders, "-" for the standard input, NULL for a batch run. */
+    char *snapshot_file_name; /**< Snapshot written when the server stops and by SNAPSHOT, NULL for none. */
+    char *restore_file_name; /**< Snapshot the server resumes from instead of loading the orders, NULL to load them. */
+    int top_count; /**< Number of customers in the top revenue and margin report, 0 to skip it. */
+    char *customer_name; /**< Customer whose revenue between two days is printed, NULL to skip it. */
+    int customer_first_day; /**< First day of the revenue of customer_name. */
+    int customer_last_day; /**< Last day of the revenue of customer_name. */
+    int inactive_days; /**< Customers without orders in this many latest days are listed, -1 to skip them. */
+    bool incremental; /**< Carries the simulation over from the previous run and reads only the appended orders. */
+    bool model_report; /**< Prints the orders, items, revenue and margin of each model over the whole history. */
+};
 
+/**
+ * Reads the command line options.
+ * @param argc Number of arguments.
+ * @param argv Arguments.
+ * @param options Pointer reference to the Options struct to fill.
+ */
+void parse_options(int argc, char **argv, struct Options *options) {
+    int i;
 
-void read_file(FILE **fptr, char* name) {
-    if ((*fptr = fopen(name, "r")) == NULL) {
-        printf("Error! opening file %s\n", name);
+    options->orders_file_name = "orders.dat";
+    options->orders_file_names = malloc(argc * sizeof(char *));
+    options->orders_file_count = 0;
+    options->sweep_grid_file_name = NULL;
+    options->sweep_output_file_name = NULL;
+    options->threads = 0;
+    options->policy = SCHEDULE_FCFS;
+    options->policy_given = false;
+    options->metrics_file_name = NULL;
+    options->events_file_name = NULL;
+    options->quiet = false;
+    options->serve_path = NULL;
+    options->snapshot_file_name = NULL;
+    options->restore_file_name = NULL;
+    options->top_count = 0;
+    options->customer_name = NULL;
+    options->customer_first_day = 0;
+    options->customer_last_day = 0;
+    options->inactive_days = -1;
+    options->incremental = false;
+    options->model_report = false;
+    if (options->orders_file_names == NULL) {
+        printf("Error! not enough memory for the options\n");
         exit(0);
-        // Program exits if file pointer returns NULL.
-    } else {
-        printf("File %s opened successfully\n", name);
     }
-}
 
-/**
- * Reads system information from the file into the SystemInfo struct
- * @param fptr Pointer to file
- * @param system_info Pointer to SystemInfo struct.
- */
-void extract_system_info(FILE *fptr, struct SystemInfo *system_info) {
-    fscanf(fptr, "%d %d\n", &system_info->storage_capacity, &system_info->number_of_workers);
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--sweep") == 0 && i + 2 < argc) {
+            options->sweep_grid_file_name = argv[++i];
+            options->sweep_output_file_name = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options->threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            int policy = schedule_policy_parse(argv[++i]);
+
+            if (policy < 0) {
+                printf("Error! unknown scheduling policy %s, use fcfs, spt or margin\n", argv[i]);
+                exit(0);
+            }
+            options->policy = (enum SchedulePolicy)policy;
+            options->policy_given = true;
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            options->metrics_file_name = argv[++i];
+        } else if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            options->events_file_name = argv[++i];
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            options->quiet = true;
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            options->serve_path = argv[++i];
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            options->snapshot_file_name = argv[++i];
+        } else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) {
+            options->restore_file_name = argv[++i];
+        } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            options->top_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--customer") == 0 && i + 3 < argc) {
+            options->customer_name = argv[++i];
+            options->customer_first_day = atoi(argv[++i]);
+            options->customer_last_day = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--inactive") == 0 && i + 1 < argc) {
+            options->inactive_days = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--incremental") == 0) {
+            options->incremental = true;
+        } else if (strcmp(argv[i], "--models") == 0) {
+            options->model_report = true;
+        } else if (argv[i][0] == '-') {
+            printf("Usage: %s [--sweep grid results.csv] [--threads count] [--policy fcfs|spt|margin] [--metrics file] [--events file] [--quiet] [--incremental] [--models] [--top count] [--customer name from to] [--inactive days] [--serve socket|- [--snapshot file] [--restore file]] [orders file...]\n", argv[0]);
+            exit(0);
+        } else {
+            options->orders_file_names[options->orders_file_count++] = argv[i];
+        }
+    }
+    if (options->orders_file_count == 0) {
+        options->orders_file_names[options->orders_file_count++] = options->orders_file_name;
+    }
+    options->orders_file_name = options->orders_file_names[0];
+    if (options->serve_path == NULL && (options->snapshot_file_name != NULL || options->restore_file_name != NULL)) {
+        printf("Error! --snapshot and --restore need --serve\n");
+        exit(0);
+    }
+    if (options->incremental && (options->orders_file_count > 1 || options->serve_path != NULL || options->sweep_grid_file_name != NULL)) {
+        printf("Error! --incremental needs one orders file and no --serve or --sweep\n");
+        exit(0);
+    }
 }
 
 /**
- * Reads models information from the file into ModelInfo structs.
- * @param fptr Pointer to file
- * @param models Pointer to array of ModelInfo structs.
+ * Runs a capacity sweep over the parameter grid and writes its table.
+ * @param options Pointer reference to the Options struct.
+ * @param orders Pointer reference to the array of Order structs, sorted by priority.
+ * @param stats Pointer reference to the ModelOrderingStats struct.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param catalog Pointer reference to the ModelCatalog struct.
  */
-void extract_models_info(FILE *fptr, struct ModelInfo *models) {
-    int i;
-    for(i = 0 ; i < TOTAL_MODELS ; ++i) {
-        fscanf(fptr, "%c %f %f %d %d\n", &models[i].model, &models[i].cost, &models[i].price, &models[i].space_required, &models[i].man_hours);
+void run_sweep(struct Options *options, struct Order *orders, struct ModelOrderingStats *stats, struct SystemInfo *system, struct ModelCatalog *catalog) {
+    FILE *grid_file_ptr, *output_file_ptr;
+    struct SweepGrid grid;
+
+    read_file(&grid_file_ptr, options->sweep_grid_file_name);
+    if (sweep_grid_read(grid_file_ptr, &grid, catalog) != 0) {
+        exit(0);
+    }
+    fclose(grid_file_ptr);
+
+    if ((output_file_ptr = fopen(options->sweep_output_file_name, "w")) == NULL) {
+        printf("Error! opening file %s\n", options->sweep_output_file_name);
+        exit(0);
     }
+    sweep_run(&grid, orders, stats->total_orders, stats, system, catalog, options->policy, options->threads, output_file_ptr);
+    fclose(output_file_ptr);
+    printf("%d scenarios written to %s\n", grid.scenario_count, options->sweep_output_file_name);
 }
 
 /**
- * Reads customer orders from file into list of Order structs
- * @param fptr Pointer to file orders.dat
- * @param orders Pointer to array of Order structs.
- * @param orders_count Number of MAX_ORDERS that can be received.
- * @param stats Pointer to ModelOrderingStats struct.
- * @return Returns the number of orders read from the file.
+ * Serves the clients of a started server until it is stopped, then saves its snapshot if one was asked for.
+ * @param options Pointer reference to the Options struct.
+ * @param server Pointer reference to the OrderServer struct.
  */
-int extract_orders_info(FILE *fptr, struct Order *orders, int orders_count, struct ModelOrderingStats *stats) {
-    int i = 0;
-    while(fscanf(fptr,"%d %c %d %s\n", &orders[i].timestamp,&orders[i].model, &orders[i].quantity, orders[i].customer) != EOF) {
-        update_ordering_stats(orders[i].model, stats);
-        i++;
-        if(orders_count == i) {
-            return i;
-        }
+void serve(struct Options *options, struct OrderServer *server) {
+    server->snapshot_file_name = options->snapshot_file_name;
+    fflush(stdout);
+    if (strcmp(options->serve_path, "-") == 0) {
+        order_server_serve_stream(server, 0, 1);
+    } else if (order_server_serve_socket(server, options->serve_path) != 0) {
+        exit(0);
+    }
+    if (options->snapshot_file_name != NULL && snapshot_write(options->snapshot_file_name, server, false) == 0) {
+        fprintf(stderr, "Snapshot of %d orders written to %s\n", server->orders_count, options->snapshot_file_name);
     }
-    return i;
 }
 
 /**
- * Updates the number of orders placed by customer according to the item model provided.
- * @param model_name Name of the item model.
- * @param orderingStats Pointer reference to the ModelOrderingStats data structure
+ * Keeps the simulation running after loading the orders and serves new orders and queries until it is stopped.
+ * The server takes over the orders array and frees it.
+ * @param options Pointer reference to the Options struct.
+ * @param orders Pointer reference to the array of Order structs allocated with malloc, sorted by priority.
+ * @param stats Pointer reference to the ModelOrderingStats struct.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param customers Pointer reference to the InternTable of the customer names.
+ * @param aggregates Pointer reference to the DailyAggregates struct.
+ * @param metrics Pointer reference to the SimulationMetrics struct to fill, NULL to skip the metrics.
+ * @param events Pointer reference to the EventLog receiving the events, NULL to skip the journal.
  */
-void update_ordering_stats(char model_name, struct ModelOrderingStats *orderingStats) {
-  switch (model_name) {
-  case 'A':
-    orderingStats->model_a_orders++;
-    break;
-  case 'B':
-    orderingStats->model_b_orders++;
-    break;
-  case 'C':
-    orderingStats->model_c_orders++;
-    break;
-  case 'D':
-    orderingStats->model_d_orders++;
-  default:
-    break;
-  }
-}
+void run_server(struct Options *options, struct Order *orders, struct ModelOrderingStats *stats, struct SystemInfo *system, struct ModelCatalog *catalog, struct InternTable *customers, struct DailyAggregates *aggregates, struct SimulationMetrics *metrics, struct EventLog *events) {
+    struct OrderServer server;
 
+    order_server_init(&server, system, catalog, stats, customers, aggregates, orders, stats->total_orders, metrics, events, options->policy);
+    serve(options, &server);
+    order_server_free(&server);
+}
 
 /**
- * Gives reference to the model struct based on model name provided
- * @param name Item model
- * @param models Pointer to the array of ModelInfo structs.
- * @return Returns reference to the ModelInfo struct associated with the model provided.
+ * Resumes the server from a snapshot instead of loading and simulating the orders, then serves until it is stopped.
+ * The server keeps the scheduling policy of the snapshot unless --policy is given.
+ * @param options Pointer reference to the Options struct.
+ * @param metrics Pointer reference to the SimulationMetrics struct.
  */
-struct ModelInfo* get_model_by_name(char name, struct ModelInfo *models) {
-    int i;
-    for(i = 0 ; i < TOTAL_MODELS ; ++i) {
-        if (models[i].model == name) {
-            return &models[i];
-        }
-    }
+void run_restored_server(struct Options *options, struct SimulationMetrics *metrics) {
+    struct MappedSnapshot snapshot;
+    struct SystemInfo system = {0};
+    struct ModelCatalog catalog;
+    struct ModelOrderingStats ordering_stats;
+    struct InternTable customers;
+    struct DailyAggregates daily_aggregates;
+    struct EventLog event_log;
+    struct OrderServer server;
+    double phase_start = metrics_now();
 
-    return NULL;
+    if (snapshot_map(options->restore_file_name, &snapshot) != 0) {
+        exit(0);
+    }
+    model_catalog_init(&catalog);
+    intern_table_init(&customers);
+    snapshot_system_info(&snapshot, &system, &catalog);
+    ordering_stats_init(&ordering_stats, catalog.count);
+    daily_aggregates_init(&daily_aggregates, catalog.models, catalog.count);
+    if (options->events_file_name != NULL && event_log_open(&event_log, options->events_file_name) != 0) {
+        exit(0);
+    }
+    order_server_init(&server, &system, &catalog, &ordering_stats, &customers, &daily_aggregates, NULL, 0,
+                      options->metrics_file_name != NULL ? metrics : NULL, options->events_file_name != NULL ? &event_log : NULL, SCHEDULE_FCFS);
+    snapshot_restore(&snapshot, &server, options->policy_given ? (int)options->policy : -1);
+    snapshot_unmap(&snapshot);
+    metrics_add_phase(metrics, "restore", metrics_now() - phase_start);
+    printf("Restored %d orders at hour %d from %s in %.3f ms\n", server.orders_count, server.scheduler.clock, options->restore_file_name, (metrics_now() - phase_start) * 1000);
+
+    serve(options, &server);
+    order_server_free(&server);
+    if (options->events_file_name != NULL) {
+        event_log_close(&event_log, &customers, &catalog);
+    }
+    daily_aggregates_free(&daily_aggregates);
+    ordering_stats_free(&ordering_stats);
+    model_catalog_free(&catalog);
+    intern_table_free(&customers);
 }
 
 /**
- * Sorts orders by priority based on quantity of the item models as well as margin associated with each item model/
- * @param orders Pointer to the array of Order structs.
- * @param models Pointer to the array of ModelInfo structs.
- * @param orders_count Number of orders received by customers.
+ * Prints the customer reports asked for on the command line: the top customers by revenue and by margin, the revenue
+ * of one customer between two days and the customers without recent orders. They are all answered from one
+ * CustomerIndex built over the orders.
+ * @param options Pointer reference to the Options struct.
+ * @param orders Pointer reference to the array of Order structs.
+ * @param orders_count Number of orders.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param customers Pointer reference to the InternTable of the customer names.
+ * @param metrics Pointer reference to the SimulationMetrics struct receiving the time to build the index.
  */
-void sort_by_priority(struct Order *orders, struct ModelInfo *models, int orders_count) {
-    int i, j;
-    struct Order temp;
-    struct ModelInfo *order_i_model_ptr, *order_j_model_ptr;
-    for(i = 0; i < orders_count; ++i) {
-
-        for (j = i + 1; j < orders_count; ++j) {
-            if (orders[i].timestamp == orders[j].timestamp) {
-                if (orders[i].quantity < orders[j].quantity) {
-
-                    temp = orders[i];
-                    orders[i] = orders[j];
-                    orders[j] = temp;
-
-                } else if (orders[j].quantity == orders[i].quantity) {
-                    order_i_model_ptr = get_model_by_name(orders[i].model, models);
-                    order_j_model_ptr = get_model_by_name(orders[j].model, models);
-
-                    if ((order_i_model_ptr->price - order_i_model_ptr->cost) <
-                        (order_j_model_ptr->price - order_j_model_ptr->cost)) {
-
-                        temp = orders[i];
-                        orders[i] = orders[j];
-                        orders[j] = temp;
+void report_customers(struct Options *options, const struct Order *orders, int orders_count, struct ModelCatalog *catalog, struct InternTable *customers, struct SimulationMetrics *metrics) {
+    struct CustomerIndex index;
+    double phase_start = metrics_now();
+    int i, count;
 
-                    }
-                }
+    customer_index_build(&index, orders, orders_count, catalog, customers->count);
+    metrics_add_phase(metrics, "customer_index_build", metrics_now() - phase_start);
 
+    printf("====================================\n");
+    printf("======= Customer Statistics ========\n");
+    printf("====================================\n");
+    if (options->top_count > 0) {
+        int *top = malloc(options->top_count * sizeof(int));
+        double *totals = malloc(options->top_count * sizeof(double));
+        int by_margin;
+
+        if (top == NULL || totals == NULL) {
+            printf("Error! not enough memory for the top %d customers\n", options->top_count);
+            exit(0);
+        }
+        for (by_margin = 0; by_margin <= 1; ++by_margin) {
+            count = customer_index_top(&index, options->top_count, by_margin, top, totals);
+            printf("Top %d customers by %s:\n", count, by_margin ? "margin" : "revenue");
+            for (i = 0; i < count; ++i) {
+                printf("%d. %s: %.2f euro\n", i + 1, intern_table_name(customers, top[i]), totals[i]);
             }
         }
-
+        free(top);
+        free(totals);
     }
-}
-
-
-/**
- * Prepares items to be stored in the stock according to the sales percentage.
- * @param stats Pointer reference to the ModelOrderingStats struct.
- * @param system Pointer reference to the SystemInfo struct.
- * @param stock  Pointer reference to the stock struct.
- * @param models Pointer reference to the array of ModelInfo struct.
- */
+    if (options->customer_name != NULL) {
+        int id = intern_table_find(customers, options->customer_name, strlen(options->customer_name));
+        double revenue, margin;
+
+        if (id < 0) {
+            printf("Customer %s has no orders\n", options->customer_name);
+        } else {
+            customer_index_range(&index, id, options->customer_first_day, options->customer_last_day, &revenue, &margin);
+            printf("Customer %s from day %d to day %d: revenue %.2f euro, margin %.2f euro\n", options->customer_name,
+                   options->customer_first_day, options->customer_last_day, revenue, margin);
+        }
+    }
+    if (options->inactive_days >= 0) {
+        const int *inactive;
 
-void prepare_for_stock(struct ModelOrderingStats *stats, struct SystemInfo *system, struct Stock *stock, struct ModelInfo *models) {
-    int i, j = 0;
-    int available_space = (system->storage_capacity - stock->occupied_space)/system->average_product_size;
-    int model_a_stocks = available_space * ((float)stats->model_a_orders/stats->total_orders*100) / 100;
-    int model_b_stocks = available_space * ((float)stats->model_b_orders/stats->total_orders*100) / 100;
-    int model_c_stocks = available_space * ((float)stats->model_c_orders/stats->total_orders*100) / 100;
-    int model_d_stocks = available_space * ((float)stats->model_d_orders/stats->total_orders*100) / 100;
-
-    j = prepare_product_for_model('A', models, stock, system, model_a_stocks, j);
-    j = prepare_product_for_model('B', models, stock, system, model_b_stocks, j);
-    j = prepare_product_for_model('C', models, stock, system, model_c_stocks, j);
-    j = prepare_product_for_model('D', models, stock, system, model_d_stocks, j);
+        count = customer_index_inactive(&index, options->inactive_days, &inactive);
+        printf("Customers without orders in the last %d days: %d\n", options->inactive_days, count);
+        for (i = 0; i < count; ++i) {
+            printf("%s\n", intern_table_name(customers, inactive[i]));
+        }
+    }
+    customer_index_free(&index);
 }
 
 /**
- * Manufacturers the product of the given model and adds it to the stock.
- * @param model Item model
- * @param models Pointer reference to the array of ModelInfo data structure
- * @param stock Pointer reference to the Stock struct.
- * @param system Pointer reference to the SystemInfo struct.
- * @param product_to_prepare Number of products to prepare for this specific model.
- * @param stock_index Current slot of the stock from where the items should be added.
- * @return Returns the new index of the stock after adding items for this model.
+ * Prints the orders, items, revenue and margin of each model over the whole history. The orders are copied to
+ * OrderColumns and reduced by order_columns_model_totals, which only reads the model and quantity columns.
+ * @param orders Pointer reference to the array of Order structs.
+ * @param orders_count Number of orders.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param metrics Pointer reference to the SimulationMetrics struct receiving the time of the reduction.
  */
-int prepare_product_for_model(char model, struct ModelInfo *models, struct Stock *stock, struct SystemInfo *system, int product_to_prepare, int stock_index) {
-    int i;
-    struct ModelInfo *model_info = get_model_by_name(model, models);
-    stock->products[stock_index].model = model;
+void report_models(const struct Order *orders, int orders_count, struct ModelCatalog *catalog, struct SimulationMetrics *metrics) {
+    struct OrderColumns columns;
+    struct ModelTotals totals;
+    double revenue, margin, phase_start = metrics_now();
+    int m;
+
+    order_columns_build(&columns, orders, orders_count, catalog->count);
+    model_totals_init(&totals, catalog->count);
+    order_columns_model_totals(&columns, 0, columns.count, &totals);
+    model_totals_revenue_margin(&totals, catalog->models, &revenue, &margin);
+    order_columns_free(&columns);
+    metrics_add_phase(metrics, "order_columns_model_totals", metrics_now() - phase_start);
 
-    for(i = 0 ; i < product_to_prepare; ++i) {
-        if (system->storage_capacity - model_info->space_required < 0) {
-            return stock_index;
-        }
+    printf("====================================\n");
+    printf("========= Model Statistics =========\n");
+    printf("====================================\n");
+    for (m = 0; m < catalog->count; ++m) {
+        struct ModelInfo *model = &catalog->models[m];
 
-        stock->products[stock_index].quantity++;
-        stock->occupied_space += model_info->space_required;
-        stock_index++;
+        printf("Model %s: %lld orders, %lld items, revenue %.2f euro, margin %.2f euro\n", model->model, totals.orders[m], totals.quantity[m],
+               (double)model->price * totals.quantity[m], (double)(model->price - model->cost) * totals.quantity[m]);
     }
-    return stock_index;
-}
-
-/**
- * Gives the average size of the item for storing in the stock based on all the item models.
- * @param models Pointer reference to the array of ModelInfo structs.
- * @return Returns average size of item.
- */
-int average_product_size(struct ModelInfo *models) {
-  int i, products_space_sum = 0;
-  
-  for(i = 0 ; i < TOTAL_MODELS; ++i) {
-    products_space_sum += models[i].space_required;
-  }
-  
-  return products_space_sum/TOTAL_MODELS;
+    if (totals.orders[catalog->count] > 0) {
+        printf("Unknown models: %lld orders, %lld items\n", totals.orders[catalog->count], totals.quantity[catalog->count]);
+    }
+    printf("All models: revenue %.2f euro, margin %.2f euro\n", revenue, margin);
+    model_totals_free(&totals);
 }
 
 /**
- * Processes the customer orders by using the already manufacturing items as well as making new items at spot.
+ * Prints the items of each model sold to each customer, the revenue and margin of the last twelve months and the
+ * model and customer reports asked for on the command line.
+ * @param options Pointer reference to the Options struct.
  * @param orders Pointer reference to the array of Order structs.
- * @param stats Pointer reference to the ModelOrderingStats struct.
- * @param system Pointer reference to the SystemInfo struct.
- * @param stock Pointer reference to the Stock struct.
- * @param models Pointer reference to the array of ModelInfo data structure
+ * @param orders_count Number of orders.
+ * @param items_sold Number of orders of each model placed by each customer, a row of catalog->count counters per
+ * customer, NULL to count them from the orders.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param customers Pointer reference to the InternTable of the customer names.
+ * @param aggregates Pointer reference to the DailyAggregates struct holding every order.
+ * @param metrics Pointer reference to the SimulationMetrics struct receiving the phase timers.
  */
-void process_orders(struct Order *orders, struct ModelOrderingStats *stats, struct SystemInfo *system, struct Stock *stock, struct ModelInfo *models) {
-    int i, k;
-    int processed_orders = 0;
-    bool stock_prepared_for_free_days = false;
-    int hour_count = 1;
-    struct Order last_order;
-
-    while (processed_orders < stats->total_orders) {
-        for(i=0; i < stats->total_orders ; ++i) {
-            update_ordering_stats(orders[i].model, stats);
-
-            if (i == 0) {
-                last_order = orders[0];
-            }
-            else {
-                last_order = orders[i - 1];
-            }
-
-            struct ModelInfo *model_info = get_model_by_name(orders[i].model, models);
-
-            if (!stock_prepared_for_free_days && orders[i].timestamp  - last_order.timestamp > 1) {
-                for (k = last_order.timestamp + 1; k < orders[i].timestamp; ++k) {
-                    printf("No orders placed on %d\n", k);
-                    printf("Prepare models for storing in stock\n");
-                    prepare_for_stock(stats, system, stock, models);
-                }
-            }
+void print_statistics(struct Options *options, const struct Order *orders, int orders_count, const int *items_sold, struct ModelCatalog *catalog, struct InternTable *customers, struct DailyAggregates *aggregates, struct SimulationMetrics *metrics) {
+    int i, m;
+    struct ItemSoldStats *item_sold_stats = NULL;
+    struct TwelveMonthStats twelve_month_stats = {0};
+    double phase_start = metrics_now();
+    int total_customers = customers->count;
+
+    if (items_sold == NULL) {
+        total_customers = calculate_items_sold_for_each_customer(orders, &item_sold_stats, customers, orders_count, catalog->count);
+        metrics_add_phase(metrics, "calculate_items_sold_for_each_customer", metrics_now() - phase_start);
+    }
 
-            if (sold_item_from_stock(orders[i].model, stock)) {
-                continue;
-            }
+    phase_start = metrics_now();
+    calculate_twelve_month_stats(aggregates, &twelve_month_stats);
+    metrics_add_phase(metrics, "calculate_twelve_month_stats", metrics_now() - phase_start);
 
-            if (orders[i].processing) {
+    printf("====================================\n");
+    printf("======= Sold Items Statistics ======\n");
+    printf("====================================\n");
+    for(i=0 ; i < total_customers ; ++i) {
+        const int *row = items_sold != NULL ? items_sold + (size_t)i * catalog->count : item_sold_stats[i].model_products;
 
-                if (orders[i].process_end_hour == hour_count) {
-                    orders[i].completed = 1;
-                    orders[i].processing = 0;
-                    system->number_of_workers += model_info->man_hours;
-                    processed_orders++;
-                    printf("Completed Order of %d items of  Model %c by %s at %d\n",orders[i].quantity, orders[i].model, orders[i].customer,  hour_count);
-                }
-            }
-            else if (!orders[i].completed) {
-                if (model_info->man_hours <= system->number_of_workers) {
-                    system->number_of_workers -= model_info->man_hours;
-                    orders[i].process_start_hour = hour_count;
-                    orders[i].process_end_hour = hour_count + model_info->man_hours;
-                    orders[i].processing = 1;
-                    printf("Started processing order of %d items of  Model %c by %s at %d\n",orders[i].quantity, orders[i].model, orders[i].customer,  hour_count);
-                }
-                else {
-                    printf("Not enough workers available, waiting");
-                }
-            }
+        printf("Customer name: %s\n", intern_table_name(customers, i));
+        for (m = 0; m < catalog->count; ++m) {
+            printf("Model %s items sold: %d\n", catalog->models[m].model, row[m]);
         }
-        stock_prepared_for_free_days = true;
-        hour_count++;
     }
-}
-
+    
 
-/**
- * Sells already made item from stock
- * @param model Item model
- * @param stock Pointer reference to Stock struct
- * @return True if item sold, otherwise false.
- */
+    printf("============================================\n");
+    printf("======= Last Twelve Months Statistics ======\n");
+    printf("============================================\n");
 
-bool sold_item_from_stock(char model, struct Stock *stock) {
-    int i;
+    printf("Margin : %lld euro\n", twelve_month_stats.margin);
+    printf("Revenue: %lld euro\n", twelve_month_stats.revenue);
 
-    for(i = 0 ; i < stock->products_index; ++i) {
-        if (stock->products[i].model == model) {
-            stock->products_index--;
-            return true;
-        }
+    if (options->model_report) {
+        report_models(orders, orders_count, catalog, metrics);
     }
-
-    return false;
+    if (options->top_count > 0 || options->customer_name != NULL || options->inactive_days >= 0) {
+        report_customers(options, orders, orders_count, catalog, customers, metrics);
+    }
+    free(item_sold_stats);
 }
 
 /**
- * Finds the ItemSoldStats object associated with the provided customer name.
- * @param name Customer name
- * @param stats Pointer reference to array of ItemSoldStats struct.
- * @param stats_count Total number of stats identified.
- * @return Pointer reference to the object associated with provided customer name.
+ * Writes the simulation metrics, as CSV if the file name ends in .csv and as JSON otherwise.
+ * @param file_name File receiving the metrics.
+ * @param metrics Pointer reference to the SimulationMetrics struct.
  */
-struct ItemSoldStats * get_stats_from_customer_name(char * name, struct ItemSoldStats *stats, int stats_count) {
-    int i;
+void write_metrics(char *file_name, struct SimulationMetrics *metrics) {
+    size_t length = strlen(file_name);
+    FILE *fptr = fopen(file_name, "w");
 
-    for(i = 0 ; i < stats_count ; ++i) {
-        if ( strcmp(stats[i].name, name) == 0 ) {
-            return &stats[i];
-        }
+    if (fptr == NULL) {
+        printf("Error! opening file %s\n", file_name);
+        return;
+    }
+    if (length >= 4 && strcmp(file_name + length - 4, ".csv") == 0) {
+        metrics_write_csv(metrics, fptr);
+    } else {
+        metrics_write_json(metrics, fptr);
     }
-    return NULL;
+    fclose(fptr);
 }
 
-
 /**
- * Calculates the amount of each item models sold to each customer.
- * @param orders Pointer reference to array of Order structs.
- * @param itemSoldStats Pointer reference to ItemSoldStats struct.
- * @param orders_count Total orders placed by customer.
- * @return Returns the total number of unique customers to whom the items were sold.
+ * Gives the simulation hour at which the orders of a day are received in an incremental run, counting days from the
+ * first order consumed, which is received at hour 1.
+ * @param first_day Timestamp of the first order consumed.
+ * @param day Timestamp of the order.
+ * @return Returns the hour, INT_MAX - 1 at most.
  */
+static int incremental_hour(int first_day, int day) {
+    long long hour = 1 + ((long long)day - first_day) * 24;
 
-int calculate_items_sold_for_each_customer(struct Order *orders, struct ItemSoldStats *itemSoldStats, int orders_count) {
-    int i, j = 0;
-
-    for(i = 0 ; i < orders_count ; ++i) {
-        struct ItemSoldStats *stat = get_stats_from_customer_name(orders[i].customer, itemSoldStats, j);
-
-        if (stat == NULL) {
-            stat = &itemSoldStats[j];
-            strcpy(itemSoldStats[j].name, orders[i].customer);
-            j++;
-        }
-        switch (orders[i].model) {
-            case 'A':
-                stat->model_a_products++;
-                break;
-            case 'B':
-                stat->model_b_products++;
-                break;
-            case 'C':
-                stat->model_c_products++;
-                break;
-            case 'D':
-                stat->model_d_products++;
-                break;
-        }
-    }
-
-    return j;
+    return hour < INT_MAX ? (int)hour : INT_MAX - 1;
 }
 
 /**
- * Sorts by most recent orders
- * @param orders Pointer referece to array of Order struct.
- * @param orders_count Total orders placed by customers.
+ * Runs an append-only orders file incrementally. Next to the orders file, a run keeps a snapshot of the simulation
+ * (orders file name followed by .state), the orders consumed (followed by .history, see order_manifest_write_history)
+ * and a manifest (followed by .manifest) holding the bytes read, their hash, the first and latest timestamps and the
+ * items of each model sold to each customer. When the manifest still matches info.dat, the
+ * policy and the consumed part of the orders file, and no new line comes before the latest timestamp, the snapshot is
+ * restored and only the new lines are parsed, sorted by priority and added; otherwise the whole file is read again
+ * from an empty state. Orders of the latest day may be appended after it was read; they follow the orders of that day
+ * read before. A last line without its new line is left for the next run.
+ * The orders of each day are received at the hour of that day, the clock running through the days in between, so
+ * only the orders still waiting or running when the run stops are saved in the snapshot. The snapshot, the history
+ * and the manifest are then written before the backlog is run to completion for the report. A run thus costs the
+ * new orders, the backlog and the size of the tables, not the length of the history, apart from hashing the bytes
+ * already consumed; only --models and the customer reports read the history file. As in the server, the stock prepared on idle days follows the orders seen so far.
+ * @param options Pointer reference to the Options struct.
+ * @param metrics Pointer reference to the SimulationMetrics struct.
  */
+void run_incremental(struct Options *options, struct SimulationMetrics *metrics) {
+    char *orders_file_name = options->orders_file_name;
+    size_t name_length = strlen(orders_file_name) + 10;
+    char *manifest_name = malloc(name_length), *state_name = malloc(name_length), *history_name = malloc(name_length);
+    const char *data, *reason = NULL;
+    size_t size, begin = 0, end;
+    uint64_t info_hash;
+    long line = 0;
+    int i, count, added = 0, rows = 0, first_record;
+    int32_t *items_sold = NULL;
+    const struct Order *history;
+    struct OrderManifest manifest;
+    struct MappedSnapshot snapshot;
+    struct SystemInfo system = {0};
+    struct ModelCatalog catalog;
+    struct ModelOrderingStats ordering_stats;
+    struct InternTable customers;
+    struct DailyAggregates daily_aggregates;
+    struct EventLog event_log;
+    struct OrderServer server;
+    struct Order *orders;
+    FILE *info_file_ptr;
+    double phase_start = metrics_now();
+
+    if (manifest_name == NULL || state_name == NULL || history_name == NULL) {
+        printf("Error! not enough memory for the options\n");
+        exit(0);
+    }
+    snprintf(manifest_name, name_length, "%s.manifest", orders_file_name);
+    snprintf(state_name, name_length, "%s.state", orders_file_name);
+    snprintf(history_name, name_length, "%s.history", orders_file_name);
+    if (order_file_is_binary(orders_file_name)) {
+        printf("Error! --incremental needs a text orders file\n");
+        exit(0);
+    }
+    if (order_manifest_hash_file("info.dat", &info_hash) != 0) {
+        printf("Error! opening file info.dat\n");
+        exit(0);
+    }
+    data = order_manifest_map_orders(orders_file_name, &size);
+
+    if (order_manifest_read(manifest_name, &manifest, &items_sold) != 0) {
+        reason = "no manifest";
+    } else if (manifest.info_hash != info_hash) {
+        reason = "info.dat changed";
+    } else if (manifest.policy != (uint32_t)options->policy) {
+        reason = "the scheduling policy changed";
+    } else if (!order_manifest_prefix_matches(data, size, &manifest)) {
+        reason = "the orders already read changed";
+    } else if (!order_manifest_orders_after(data + manifest.orders_offset, data + size, manifest.last_timestamp)) {
+        reason = "new orders come before the orders already read";
+    } else if (!order_manifest_history_holds(history_name, manifest.order_count)) {
+        reason = "the history does not match the manifest";
+    } else if (snapshot_map(state_name, &snapshot) != 0) {
+        reason = "no valid state";
+    } else if (snapshot.header->total_orders != manifest.order_count || snapshot.header->customer_count != manifest.customer_count
+               || snapshot.header->model_count != manifest.model_count) {
+        snapshot_unmap(&snapshot);
+        reason = "the state does not match the manifest";
+    }
 
-void sort_by_day(struct Order *orders, int orders_count) {
-    int i, j ;
+    model_catalog_init(&catalog);
+    intern_table_init(&customers);
+    if (reason == NULL) {
+        snapshot_system_info(&snapshot, &system, &catalog);
+        begin = manifest.orders_offset;
+        line = (long)manifest.lines;
+        rows = manifest.customer_count;
+    } else {
+        printf("Reading the whole of %s: %s\n", orders_file_name, reason);
+        read_file(&info_file_ptr, "info.dat");
+        extract_system_info(info_file_ptr, &system);
+        extract_models_info(info_file_ptr, &catalog);
+        fclose(info_file_ptr);
+        system.average_product_size = average_product_size(&catalog);
+        memset(&manifest, 0, sizeof(manifest));
+        manifest.prefix_hash = ORDER_MANIFEST_HASH_SEED;
+        manifest.first_timestamp = manifest.last_timestamp = -1;
+    }
+    ordering_stats_init(&ordering_stats, catalog.count);
+    daily_aggregates_init(&daily_aggregates, catalog.models, catalog.count);
+    if (options->events_file_name != NULL && event_log_open(&event_log, options->events_file_name) != 0) {
+        exit(0);
+    }
+    order_server_init(&server, &system, &catalog, &ordering_stats, &customers, &daily_aggregates, NULL, 0,
+                      options->metrics_file_name != NULL ? metrics : NULL, options->events_file_name != NULL ? &event_log : NULL, options->policy);
+    if (reason == NULL) {
+        snapshot_restore(&snapshot, &server, -1);
+        snapshot_unmap(&snapshot);
+        printf("Resumed %d orders of %s from %s\n", manifest.order_count, orders_file_name, state_name);
+    }
+
+    for (end = size; end > begin && data[end - 1] != '\n'; --end) {
+    }
+    if (end < size) {
+        printf("The last line of %s is not complete, it is left for the next run\n", orders_file_name);
+    }
+    count = order_reader_parse_lines(data + begin, data + end, &line, &catalog.names, &customers, &orders);
+    metrics_add_phase(metrics, "load", metrics_now() - phase_start);
+    printf("Orders found : %d\n", manifest.order_count + count);
+    printf("New orders : %d\n", count);
+
+    items_sold = realloc(items_sold, ((size_t)customers.count * catalog.count + 1) * sizeof(int32_t));
+    if (items_sold == NULL) {
+        printf("Error! not enough memory for %d customers\n", customers.count);
+        exit(0);
+    }
+    memset(items_sold + (size_t)rows * catalog.count, 0, (size_t)(customers.count - rows) * catalog.count * sizeof(int32_t));
+
+    phase_start = metrics_now();
+    sort_by_priority(orders, &catalog, count);
+    metrics_add_phase(metrics, "sort_by_priority", metrics_now() - phase_start);
+    if (!options->quiet) {
+        printf("%15s %15s  %15s  %15s\n", "Customer", "Quantity", "Model", "Timestamp");
+        for(i = 0 ; i < count; ++i) {
+            printf("%14s  %14d  %14s  %14d\n", order_customer_name(&customers, orders[i].customer_id), orders[i].quantity, model_catalog_name(&catalog, orders[i].model_id), orders[i].timestamp);
+        }
+    }
 
-    struct Order temp;
+    phase_start = metrics_now();
+    server.scheduler.log = options->quiet || options->events_file_name != NULL ? NULL : stdout;
+    for (i = 0; i < count; ++i) {
+        struct Order order = orders[i];
 
-    for(i = 0; i < orders_count; ++i) {
-        for (j = i + 1; j < orders_count; ++j) {
-            if (orders[i].timestamp > orders[j].timestamp) {
-                temp = orders[i];
-                orders[i] = orders[j];
-                orders[j] = temp;
-            }
+        if (!daily_aggregates_holds(&daily_aggregates, order.timestamp)) {
+            printf("Order of %s on day %d is too far from the other orders, skipping\n", order_customer_name(&customers, order.customer_id), order.timestamp);
+            continue;
         }
+        if (manifest.first_timestamp < 0) {
+            manifest.first_timestamp = order.timestamp;
+        }
+        if (order.timestamp != manifest.last_timestamp) {
+            scheduler_run(&server.scheduler, server.orders, server.system, incremental_hour(manifest.first_timestamp, order.timestamp));
+            manifest.last_timestamp = order.timestamp;
+        }
+        order_server_add(&server, &order);
+        if (order.model_id >= 0 && order.model_id < catalog.count && order.customer_id >= 0 && order.customer_id < customers.count) {
+            items_sold[(size_t)order.customer_id * catalog.count + order.model_id]++;
+        }
+        orders[added++] = order;
     }
-}
+    scheduler_run(&server.scheduler, server.orders, server.system, server.scheduler.clock);
+
+    manifest.policy = (uint32_t)options->policy;
+    manifest.orders_offset = end;
+    manifest.prefix_hash = order_manifest_hash(data + begin, end - begin, manifest.prefix_hash);
+    manifest.info_hash = info_hash;
+    manifest.lines = line;
+    manifest.customer_count = customers.count;
+    manifest.model_count = catalog.count;
+    first_record = manifest.order_count;
+    manifest.order_count += added;
+    if (order_manifest_write_history(history_name, orders, first_record, added) != 0
+        || snapshot_write(state_name, &server, true) != 0
+        || order_manifest_write(manifest_name, &manifest, items_sold) != 0) {
+        printf("The state of %s could not be saved, the next run reads the whole file\n", orders_file_name);
+        remove(manifest_name);
+    }
+    order_manifest_unmap_orders(data, size);
 
-/**
- * Calculate the stats over the last 12 months
- * @param orders Pointer reference to the array of Order structs.
- * @param models Pointer reference to the array of ModelInfo structs/
- * @param stats Pointer reference to the TwelveMonthStats struct.
- * @param orders_count Total number of orders placed by customers.
- */
-void calculate_twelve_month_stats(struct Order *orders, struct ModelInfo *models, struct TwelveMonthStats *stats, int orders_count) {
-  int i;
-  int end_day = orders[orders_count - 1].timestamp - 365;
-  
-  for( i = orders_count - 1 ; i >= 0 ; --i) {
-    if (orders[i].timestamp < end_day) {
-      break;
-    }
-    struct ModelInfo *model_info = get_model_by_name(orders[i].model, models);
-    stats->revenue += model_info->price * orders[i].quantity;
-    stats->margin += (model_info->price - model_info->cost) * orders[i].quantity;
-  }
-}
+    simulation_finish(server.orders, server.system, &server.scheduler, &server.result);
+    if (options->events_file_name != NULL) {
+        event_log_close(&event_log, &customers, &catalog);
+    }
+    metrics_add_phase(metrics, "process_orders", metrics_now() - phase_start);
+    printf("Policy %s: makespan %d hours, %d orders processed, throughput %.3f orders per hour\n",
+           schedule_policy_name(options->policy), server.result.makespan, server.result.processed_orders, server.result.throughput);
+
+    history = order_manifest_map_history(history_name, manifest.order_count);
+    if (history != NULL) {
+        print_statistics(options, history, manifest.order_count, items_sold, &catalog, &customers, &daily_aggregates, metrics);
+        order_manifest_unmap_history(history, manifest.order_count);
+    } else {
+        print_statistics(options, orders, added, items_sold, &catalog, &customers, &daily_aggregates, metrics);
+    }
 
+    free(orders);
+    free(items_sold);
+    order_server_free(&server);
+    daily_aggregates_free(&daily_aggregates);
+    ordering_stats_free(&ordering_stats);
+    model_catalog_free(&catalog);
+    intern_table_free(&customers);
+    free(manifest_name);
+    free(state_name);
+    free(history_name);
+}
 
 /**
  * Main entry point of the program.
+ * Usage: ./main [--sweep grid results.csv] [--threads count] [--policy fcfs|spt|margin] [--metrics file] [--events file] [--quiet]
+ * [--incremental] [--models] [--top count] [--customer name from to] [--inactive days] [--serve socket|- [--snapshot file] [--restore file]]
+ * [orders file...].
+ * The orders file defaults to orders.dat; a binary order file made by order_convert is mapped in memory and also
+ * provides the system and model information, so info.dat is not read. Several text orders files, one per sales
+ * channel, are merged by timestamp as they are read (see order_merge), which also leaves them sorted by priority.
+ * With --sweep, every scenario of the parameter grid is simulated in parallel and only the table is written.
+ * With --metrics, counters, histograms and phase timers of the run are written to the given file. With --events,
+ * the simulation events go to a binary journal written by a background thread (see event_render) instead of the
+ * console. --quiet drops the order table and the message printed for every order started and completed.
+ * --policy chooses which waiting order gets the workers first (see SchedulePolicy); the makespan and throughput of
+ * the run are printed after the simulation.
+ * --models adds the totals of each model over the whole history (see report_models), and --top, --customer and
+ * --inactive add customer reports after the statistics (see report_customers).
+ * With --serve, the loaded orders are simulated and the program then keeps running, accepting new orders and queries
+ * on a Unix socket, or on the standard input and output with "-", until SHUTDOWN (see order_server_execute).
+ * --snapshot saves the state of the server when it stops, and --restore resumes a server from such a snapshot
+ * without reading info.dat or the orders. --incremental only reads the lines appended to the orders file since the
+ * previous run (see run_incremental).
  * @return Return 0 if programs executed successfully.
  */
-int main() {
-    int i, total_orders = 0;
+int main(int argc, char **argv) {
+    int i;
+    struct Options options;
+    char *orders_file_name;
+    bool binary;
     FILE *info_file_ptr, *orders_file_ptr;
-    struct SystemInfo system;
-    struct ModelInfo models[TOTAL_MODELS];
+    struct MappedOrderFile mapped_file;
+    struct SystemInfo system = {0};
+    struct ModelCatalog catalog;
     struct ModelOrderingStats ordering_stats;
-    struct Order orders[20];
-    struct ItemSoldStats item_sold_stats[20];
-    struct TwelveMonthStats twelve_month_stats;
+    struct Order *orders;
+    struct InternTable customers;
+    struct OrderColumns columns;
+    struct DailyAggregates daily_aggregates;
     struct Stock stock;
+    struct SimulationResult simulation;
+    struct SimulationMetrics metrics;
+    struct EventLog event_log;
+    double phase_start;
+
+    parse_options(argc, argv, &options);
+    metrics_init(&metrics);
+    if (options.restore_file_name != NULL) {
+        run_restored_server(&options, &metrics);
+        if (options.metrics_file_name != NULL) {
+            write_metrics(options.metrics_file_name, &metrics);
+        }
+        free(options.orders_file_names);
+        return 0;
+    }
+    if (options.incremental) {
+        run_incremental(&options, &metrics);
+        if (options.metrics_file_name != NULL) {
+            write_metrics(options.metrics_file_name, &metrics);
+        }
+        free(options.orders_file_names);
+        return 0;
+    }
+    phase_start = metrics_now();
+    orders_file_name = options.orders_file_name;
+    binary = order_file_is_binary(orders_file_name);
+    for (i = 1; i < options.orders_file_count; ++i) {
+        if (binary || order_file_is_binary(options.orders_file_names[i])) {
+            printf("Error! only text orders files can be merged\n");
+            exit(0);
+        }
+    }
 
-    read_file(&info_file_ptr, "info.dat");
-    extract_system_info(info_file_ptr, &system);
-    extract_models_info(info_file_ptr, models);
+    intern_table_init(&customers);
+    model_catalog_init(&catalog);
+    if (binary) {
+        if (order_file_map(orders_file_name, &mapped_file) != 0) {
+            exit(0);
+        }
+        printf("File %s mapped successfully\n", orders_file_name);
+        order_file_system_info(&mapped_file, &system, &catalog);
+        ordering_stats_init(&ordering_stats, catalog.count);
+        ordering_stats.total_orders = order_file_orders(&mapped_file, &orders, &ordering_stats, &customers);
+    } else {
+        read_file(&info_file_ptr, "info.dat");
+        extract_system_info(info_file_ptr, &system);
+        extract_models_info(info_file_ptr, &catalog);
+        fclose(info_file_ptr);
+
+        ordering_stats_init(&ordering_stats, catalog.count);
+        if (options.orders_file_count > 1) {
+            ordering_stats.total_orders = extract_merged_orders_info(options.orders_file_names, options.orders_file_count, &orders, &ordering_stats, &catalog, &customers);
+        } else {
+            read_file(&orders_file_ptr, orders_file_name);
+            ordering_stats.total_orders = extract_orders_info_parallel(orders_file_ptr, &orders, &ordering_stats, &catalog, &customers, options.threads);
+            fclose(orders_file_ptr);
+        }
+    }
+
+    system.average_product_size = average_product_size(&catalog);
 
-    read_file(&orders_file_ptr, "orders.dat");
-    ordering_stats.total_orders = extract_orders_info(orders_file_ptr, orders, 100, &ordering_stats);
+    daily_aggregates_init(&daily_aggregates, catalog.models, catalog.count);
+    if (binary) {
+        daily_aggregates_build(&daily_aggregates, &mapped_file.columns);
+    } else {
+        order_columns_build(&columns, orders, ordering_stats.total_orders, catalog.count);
+        daily_aggregates_build(&daily_aggregates, &columns);
+        order_columns_free(&columns);
+    }
 
-    system.average_product_size = average_product_size(models);
+    metrics_add_phase(&metrics, "load", metrics_now() - phase_start);
 
     printf("Orders found : %d\n", ordering_stats.total_orders);
     
-    sort_by_priority(orders, models, ordering_stats.total_orders);
+    phase_start = metrics_now();
+    if (options.orders_file_count == 1) {
+        sort_by_priority(orders, &catalog, ordering_stats.total_orders);
+    }
+    metrics_add_phase(&metrics, "sort_by_priority", metrics_now() - phase_start);
 
-    printf("%15s %15s  %15s  %15s\n", "Customer", "Quantity", "Model", "Timestamp");
-    for(i = 0 ; i < ordering_stats.total_orders; ++i) {
-        printf("%14s  %14d  %14c  %14d\n", orders[i].customer, orders[i].quantity, orders[i].model, orders[i].timestamp);
+    if (options.sweep_grid_file_name != NULL) {
+        run_sweep(&options, orders, &ordering_stats, &system, &catalog);
+        if (binary) {
+            order_file_unmap(&mapped_file);
+        }
+        daily_aggregates_free(&daily_aggregates);
+        ordering_stats_free(&ordering_stats);
+        model_catalog_free(&catalog);
+        intern_table_free(&customers);
+        free(orders);
+        free(options.orders_file_names);
+        return 0;
     }
-    
-    process_orders(orders, &ordering_stats, &system, &stock, models);
 
-    int total_customers = calculate_items_sold_for_each_customer(orders, item_sold_stats, ordering_stats.total_orders);
-    
-    sort_by_day(orders, ordering_stats.total_orders);
-    
-    calculate_twelve_month_stats(orders, models, &twelve_month_stats, ordering_stats.total_orders);
+    if (options.events_file_name != NULL && event_log_open(&event_log, options.events_file_name) != 0) {
+        exit(0);
+    }
+    if (options.serve_path != NULL) {
+        run_server(&options, orders, &ordering_stats, &system, &catalog, &customers, &daily_aggregates,
+                   options.metrics_file_name != NULL ? &metrics : NULL, options.events_file_name != NULL ? &event_log : NULL);
+        if (options.events_file_name != NULL) {
+            event_log_close(&event_log, &customers, &catalog);
+        }
+        if (options.metrics_file_name != NULL) {
+            write_metrics(options.metrics_file_name, &metrics);
+        }
+        if (binary) {
+            order_file_unmap(&mapped_file);
+        }
+        daily_aggregates_free(&daily_aggregates);
+        ordering_stats_free(&ordering_stats);
+        model_catalog_free(&catalog);
+        intern_table_free(&customers);
+        free(options.orders_file_names);
+        return 0;
+    }
 
-    printf("====================================\n");
-    printf("======= Sold Items Statistics ======\n");
-    printf("====================================\n");
-    for(i=0 ; i < total_customers ; ++i) {
-        printf("Customer name: %s\n", item_sold_stats[i].name);
-        printf("Model A items sold: %d\n", item_sold_stats[i].model_a_products);
-        printf("Model B items sold: %d\n", item_sold_stats[i].model_b_products);
-        printf("Model C items sold: %d\n", item_sold_stats[i].model_c_products);
-        printf("Model D items sold: %d\n", item_sold_stats[i].model_d_products);
+    if (!options.quiet) {
+        printf("%15s %15s  %15s  %15s\n", "Customer", "Quantity", "Model", "Timestamp");
+        for(i = 0 ; i < ordering_stats.total_orders; ++i) {
+            printf("%14s  %14d  %14s  %14d\n", order_customer_name(&customers, orders[i].customer_id), orders[i].quantity, model_catalog_name(&catalog, orders[i].model_id), orders[i].timestamp);
+        }
     }
     
+    phase_start = metrics_now();
+    stock_init(&stock, system.storage_capacity, catalog.models, catalog.count);
+    process_orders(orders, &ordering_stats, &system, &stock, &catalog, &customers, options.quiet || options.events_file_name != NULL ? NULL : stdout,
+                   options.metrics_file_name != NULL ? &metrics : NULL, options.events_file_name != NULL ? &event_log : NULL,
+                   options.policy, &simulation);
+    stock_free(&stock);
+    if (options.events_file_name != NULL) {
+        event_log_close(&event_log, &customers, &catalog);
+    }
+    metrics_add_phase(&metrics, "process_orders", metrics_now() - phase_start);
+    printf("Policy %s: makespan %d hours, %d orders processed, throughput %.3f orders per hour\n",
+           schedule_policy_name(options.policy), simulation.makespan, simulation.processed_orders, simulation.throughput);
+    simulation_result_free(&simulation);
 
-    printf("============================================\n");
-    printf("======= Last Twelve Months Statistics ======\n");
-    printf("============================================\n");
+    print_statistics(&options, orders, ordering_stats.total_orders, NULL, &catalog, &customers, &daily_aggregates, &metrics);
 
-    printf("Margin : %d euro\n", twelve_month_stats.margin);
-    printf("Revenue: %d euro\n", twelve_month_stats.revenue);
+    if (options.metrics_file_name != NULL) {
+        write_metrics(options.metrics_file_name, &metrics);
+    }
 
-    fclose(info_file_ptr);
-    fclose(orders_file_ptr);
-    free(info_file_ptr);
-    free(orders_file_ptr);
+    if (binary) {
+        order_file_unmap(&mapped_file);
+    }
+    free(orders);
+    daily_aggregates_free(&daily_aggregates);
+    ordering_stats_free(&ordering_stats);
+    model_catalog_free(&catalog);
+    intern_table_free(&customers);
+    free(options.orders_file_names);
     return 0;
 }
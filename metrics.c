@@ -0,0 +1,217 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include "metrics.h"
+
+/**
+ * Prepares empty metrics.
+ * @param metrics Pointer reference to the SimulationMetrics struct.
+ */
+void metrics_init(struct SimulationMetrics *metrics) {
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->wait_hours.min = LLONG_MAX;
+    metrics->turnaround_hours.min = LLONG_MAX;
+    metrics->ready_depth.min = LLONG_MAX;
+}
+
+/**
+ * Bucket of a value: 0 up to 0, then the number of bits of the value.
+ */
+static int bucket_of_value(long long value) {
+    int bucket = 0;
+    unsigned long long v = (unsigned long long)value;
+
+    if (value <= 0) {
+        return 0;
+    }
+    while (v != 0 && bucket < HISTOGRAM_BUCKETS - 1) {
+        v >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * Adds a value to a histogram.
+ * @param histogram Pointer reference to the Histogram struct.
+ * @param value Value recorded.
+ */
+void histogram_record(struct Histogram *histogram, long long value) {
+    histogram->buckets[bucket_of_value(value)]++;
+    histogram->count++;
+    histogram->sum += value;
+    if (value < histogram->min) histogram->min = value;
+    if (value > histogram->max) histogram->max = value;
+}
+
+/**
+ * Estimates a percentile of a histogram as the upper bound of the bucket holding it, clamped to the maximum.
+ * @param histogram Pointer reference to the Histogram struct.
+ * @param fraction Percentile wanted, from 0 to 1.
+ * @return Returns the estimate, 0 for an empty histogram.
+ */
+long long histogram_percentile(struct Histogram *histogram, double fraction) {
+    long long seen = 0, rank = (long long)(fraction * histogram->count);
+    int b;
+
+    if (histogram->count == 0) {
+        return 0;
+    }
+    if (rank >= histogram->count) {
+        rank = histogram->count - 1;
+    }
+    for (b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+        seen += histogram->buckets[b];
+        if (seen > rank) {
+            long long upper = b == 0 ? 0 : (b >= 63 ? LLONG_MAX : (1LL << b) - 1);
+            if (upper > histogram->max) upper = histogram->max;
+            if (upper < histogram->min) upper = histogram->min;
+            return upper;
+        }
+    }
+    return histogram->max;
+}
+
+/**
+ * Accounts for hours during which the number of busy workers did not change.
+ * @param metrics Pointer reference to the SimulationMetrics struct.
+ * @param busy_workers Workers processing orders.
+ * @param total_workers Workers employed, busy or not.
+ * @param hours Length of the interval.
+ */
+void metrics_record_interval(struct SimulationMetrics *metrics, int busy_workers, int total_workers, int hours) {
+    int bucket;
+
+    if (hours <= 0) {
+        return;
+    }
+    metrics->hours_simulated += hours;
+    metrics->busy_worker_hours += (long long)busy_workers * hours;
+    metrics->available_worker_hours += (long long)total_workers * hours;
+    bucket = total_workers > 0 ? (int)((long long)busy_workers * UTILIZATION_BUCKETS / total_workers) : 0;
+    if (bucket >= UTILIZATION_BUCKETS) {
+        bucket = UTILIZATION_BUCKETS - 1;
+    }
+    metrics->utilization_hours[bucket] += hours;
+}
+
+/**
+ * Current time of the monotonic clock in seconds, for the phase timers.
+ */
+double metrics_now(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * Adds a phase timer. Timers beyond MAX_PHASES are dropped.
+ * @param metrics Pointer reference to the SimulationMetrics struct.
+ * @param name Name of the phase, not copied.
+ * @param seconds Time spent in the phase.
+ */
+void metrics_add_phase(struct SimulationMetrics *metrics, const char *name, double seconds) {
+    if (metrics->phase_count < MAX_PHASES) {
+        metrics->phases[metrics->phase_count].name = name;
+        metrics->phases[metrics->phase_count].seconds = seconds;
+        metrics->phase_count++;
+    }
+}
+
+/**
+ * Share of a over b, 0 when b is 0.
+ */
+static double ratio(long long a, long long b) {
+    return b > 0 ? (double)a / b : 0;
+}
+
+/**
+ * Writes one histogram as a JSON object.
+ */
+static void histogram_write_json(struct Histogram *histogram, const char *name, FILE *fptr) {
+    int b, last = 0;
+
+    for (b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+        if (histogram->buckets[b] > 0) last = b;
+    }
+    fprintf(fptr, "  \"%s\": {\"count\": %lld, \"sum\": %lld, \"min\": %lld, \"max\": %lld, \"mean\": %.3f, \"p50\": %lld, \"p90\": %lld, \"p99\": %lld, \"buckets\": [",
+            name, histogram->count, histogram->sum, histogram->count > 0 ? histogram->min : 0, histogram->count > 0 ? histogram->max : 0,
+            ratio(histogram->sum, histogram->count), histogram_percentile(histogram, 0.5), histogram_percentile(histogram, 0.9), histogram_percentile(histogram, 0.99));
+    for (b = 0; b <= last; ++b) {
+        fprintf(fptr, "%s%lld", b > 0 ? ", " : "", histogram->buckets[b]);
+    }
+    fprintf(fptr, "]},\n");
+}
+
+/**
+ * Writes the metrics as a JSON object.
+ * @param metrics Pointer reference to the SimulationMetrics struct.
+ * @param fptr File receiving the metrics.
+ */
+void metrics_write_json(struct SimulationMetrics *metrics, FILE *fptr) {
+    int i;
+
+    fprintf(fptr, "{\n");
+    fprintf(fptr, "  \"hours_simulated\": %lld,\n", metrics->hours_simulated);
+    fprintf(fptr, "  \"worker_utilization\": %.6f,\n", ratio(metrics->busy_worker_hours, metrics->available_worker_hours));
+    fprintf(fptr, "  \"utilization_hours\": [");
+    for (i = 0; i < UTILIZATION_BUCKETS; ++i) {
+        fprintf(fptr, "%s%lld", i > 0 ? ", " : "", metrics->utilization_hours[i]);
+    }
+    fprintf(fptr, "],\n");
+    fprintf(fptr, "  \"stock_lookups\": %lld,\n", metrics->stock_lookups);
+    fprintf(fptr, "  \"stock_hits\": %lld,\n", metrics->stock_hits);
+    fprintf(fptr, "  \"stock_hit_rate\": %.6f,\n", ratio(metrics->stock_hits, metrics->stock_lookups));
+    fprintf(fptr, "  \"blocked_dispatches\": %lld,\n", metrics->blocked_dispatches);
+    histogram_write_json(&metrics->wait_hours, "wait_hours", fptr);
+    histogram_write_json(&metrics->turnaround_hours, "turnaround_hours", fptr);
+    histogram_write_json(&metrics->ready_depth, "ready_depth", fptr);
+    fprintf(fptr, "  \"phases\": {");
+    for (i = 0; i < metrics->phase_count; ++i) {
+        fprintf(fptr, "%s\"%s\": %.6f", i > 0 ? ", " : "", metrics->phases[i].name, metrics->phases[i].seconds);
+    }
+    fprintf(fptr, "}\n}\n");
+}
+
+/**
+ * Writes the summary of one histogram as CSV rows.
+ */
+static void histogram_write_csv(struct Histogram *histogram, const char *name, FILE *fptr) {
+    fprintf(fptr, "%s.count,%lld\n", name, histogram->count);
+    fprintf(fptr, "%s.min,%lld\n", name, histogram->count > 0 ? histogram->min : 0);
+    fprintf(fptr, "%s.max,%lld\n", name, histogram->count > 0 ? histogram->max : 0);
+    fprintf(fptr, "%s.mean,%.3f\n", name, ratio(histogram->sum, histogram->count));
+    fprintf(fptr, "%s.p50,%lld\n", name, histogram_percentile(histogram, 0.5));
+    fprintf(fptr, "%s.p90,%lld\n", name, histogram_percentile(histogram, 0.9));
+    fprintf(fptr, "%s.p99,%lld\n", name, histogram_percentile(histogram, 0.99));
+}
+
+/**
+ * Writes the metrics as CSV, one metric,value row each.
+ * @param metrics Pointer reference to the SimulationMetrics struct.
+ * @param fptr File receiving the metrics.
+ */
+void metrics_write_csv(struct SimulationMetrics *metrics, FILE *fptr) {
+    int i;
+
+    fprintf(fptr, "metric,value\n");
+    fprintf(fptr, "hours_simulated,%lld\n", metrics->hours_simulated);
+    fprintf(fptr, "worker_utilization,%.6f\n", ratio(metrics->busy_worker_hours, metrics->available_worker_hours));
+    for (i = 0; i < UTILIZATION_BUCKETS; ++i) {
+        fprintf(fptr, "utilization_hours.%d-%d,%lld\n", i * 100 / UTILIZATION_BUCKETS, (i + 1) * 100 / UTILIZATION_BUCKETS, metrics->utilization_hours[i]);
+    }
+    fprintf(fptr, "stock_lookups,%lld\n", metrics->stock_lookups);
+    fprintf(fptr, "stock_hits,%lld\n", metrics->stock_hits);
+    fprintf(fptr, "stock_hit_rate,%.6f\n", ratio(metrics->stock_hits, metrics->stock_lookups));
+    fprintf(fptr, "blocked_dispatches,%lld\n", metrics->blocked_dispatches);
+    histogram_write_csv(&metrics->wait_hours, "wait_hours", fptr);
+    histogram_write_csv(&metrics->turnaround_hours, "turnaround_hours", fptr);
+    histogram_write_csv(&metrics->ready_depth, "ready_depth", fptr);
+    for (i = 0; i < metrics->phase_count; ++i) {
+        fprintf(fptr, "phase.%s.seconds,%.6f\n", metrics->phases[i].name, metrics->phases[i].seconds);
+    }
+}
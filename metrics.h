@@ -0,0 +1,58 @@
+#ifndef ORDER_SYSTEM_METRICS_H
+#define ORDER_SYSTEM_METRICS_H
+#include <stdio.h>
+#include <stdbool.h>
+#define HISTOGRAM_BUCKETS 64
+#define UTILIZATION_BUCKETS 10
+#define MAX_PHASES 16
+/** @file */
+
+/**
+ * Histogram with power of two buckets: bucket 0 counts the values up to 0 and bucket k the values from 2^(k-1)
+ * to 2^k - 1. Count, sum, minimum and maximum are exact.
+ */
+struct Histogram {
+    long long buckets[HISTOGRAM_BUCKETS]; /**< Number of values of each bucket. */
+    long long count; /**< Number of values recorded. */
+    long long sum; /**< Sum of the values recorded. */
+    long long min; /**< Smallest value recorded. */
+    long long max; /**< Largest value recorded. */
+};
+
+/**
+ * Wall clock time of one phase of the program.
+ */
+struct PhaseTimer {
+    const char *name; /**< Name of the phase. */
+    double seconds; /**< Time spent in the phase. */
+};
+
+/**
+ * Counters and histograms filled while simulating. Recording only touches a few integers, so the hot loop is
+ * unaffected; everything is summarised when the metrics are written at the end.
+ */
+struct SimulationMetrics {
+    long long hours_simulated; /**< Hours the simulation clock moved forward. */
+    long long busy_worker_hours; /**< Sum over the hours simulated of the workers busy. */
+    long long available_worker_hours; /**< Sum over the hours simulated of the workers employed. */
+    long long utilization_hours[UTILIZATION_BUCKETS]; /**< Hours spent with 0-10%, 10-20%, ... of the workers busy. */
+    long long stock_lookups; /**< Orders checked against the stock. */
+    long long stock_hits; /**< Orders served from the stock. */
+    long long blocked_dispatches; /**< Dispatches which left orders waiting for workers. */
+    struct Histogram wait_hours; /**< Hours each order started spent waiting for workers since it was submitted. */
+    struct Histogram turnaround_hours; /**< Hours from submission to completion of each order started. */
+    struct Histogram ready_depth; /**< Orders waiting for workers after each dispatch. */
+    struct PhaseTimer phases[MAX_PHASES]; /**< Phase timers, in the order they were added. */
+    int phase_count; /**< Number of phase timers. */
+};
+
+void metrics_init(struct SimulationMetrics *);
+void histogram_record(struct Histogram *, long long);
+long long histogram_percentile(struct Histogram *, double);
+void metrics_record_interval(struct SimulationMetrics *, int, int, int);
+double metrics_now(void);
+void metrics_add_phase(struct SimulationMetrics *, const char *, double);
+void metrics_write_json(struct SimulationMetrics *, FILE *);
+void metrics_write_csv(struct SimulationMetrics *, FILE *);
+
+#endif //ORDER_SYSTEM_METRICS_H
@@ -0,0 +1,272 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "order_system.h"
+#include "order_generator.h"
+#include "order_store.h"
+#include "daily_stats.h"
+#include "scheduler.h"
+#include "stock.h"
+
+#define MAX_BENCH_SIZES 32
+
+/**
+ * Holds the command line options of the benchmark.
+ */
+struct BenchOptions {
+    long long sizes[MAX_BENCH_SIZES]; /**< Number of orders of each run. */
+    int size_count; /**< Number of runs. */
+    bool json; /**< Writes a JSON array instead of CSV. */
+    char *info_file_name; /**< System and model information. */
+    enum SchedulePolicy policy; /**< Scheduling policy of the simulation. */
+    struct GeneratorOptions generator; /**< Shape of the generated orders, orders is overwritten by each size. */
+};
+
+/**
+ * Timing of one phase of a run.
+ */
+struct PhaseResult {
+    const char *phase; /**< Name of the function measured. */
+    double seconds; /**< Wall clock time of the phase. */
+    long max_rss_kb; /**< Peak resident set size of the run once the phase is over. */
+};
+
+/**
+ * Current time of the monotonic clock in seconds.
+ */
+static double now_seconds(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * Peak resident set size of the process in kilobytes.
+ */
+static long peak_rss_kb(void) {
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * Reads a comma separated list of sizes.
+ * @return Returns 0 on success, -1 for an invalid list.
+ */
+static int parse_sizes(char *value, struct BenchOptions *options) {
+    options->size_count = 0;
+    while (*value != '\0') {
+        char *end;
+        long long size = strtoll(value, &end, 10);
+
+        if (end == value || size <= 0 || size > 2147483647LL || options->size_count == MAX_BENCH_SIZES || (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        options->sizes[options->size_count++] = size;
+        value = *end == ',' ? end + 1 : end;
+    }
+    return options->size_count > 0 ? 0 : -1;
+}
+
+/**
+ * Reads the command line options.
+ */
+static void parse_bench_options(int argc, char **argv, struct BenchOptions *options) {
+    int i;
+    static const long long default_sizes[] = {1000, 10000, 100000, 1000000};
+
+    memcpy(options->sizes, default_sizes, sizeof(default_sizes));
+    options->size_count = sizeof(default_sizes) / sizeof(default_sizes[0]);
+    options->json = false;
+    options->info_file_name = "info.dat";
+    options->policy = SCHEDULE_FCFS;
+    generator_options_init(&options->generator);
+    options->generator.customers = 10000;
+
+    for (i = 1; i < argc; ++i) {
+        int status = -1;
+
+        if (strcmp(argv[i], "--json") == 0) {
+            options->json = true;
+            continue;
+        }
+        if (i + 1 < argc) {
+            if (strcmp(argv[i], "--sizes") == 0) {
+                status = parse_sizes(argv[i + 1], options);
+            } else if (strcmp(argv[i], "--info") == 0) {
+                options->info_file_name = argv[i + 1];
+                status = 0;
+            } else if (strcmp(argv[i], "--policy") == 0) {
+                int policy = schedule_policy_parse(argv[i + 1]);
+
+                options->policy = policy >= 0 ? (enum SchedulePolicy)policy : SCHEDULE_FCFS;
+                status = policy >= 0 ? 0 : -1;
+            } else if (strcmp(argv[i], "--orders") != 0) {
+                status = generator_options_parse(&options->generator, argv[i], argv[i + 1]);
+            }
+        }
+        if (status != 0) {
+            printf("Usage: %s [--sizes n1,n2,...] [--json] [--info info.dat] [--policy fcfs|spt|margin] [--customers count] [--mix a,b,c,d] [--gap days] [--burst count] [--quantity count] [--seed value]\n", argv[0]);
+            exit(1);
+        }
+        ++i;
+    }
+}
+
+/**
+ * Generates the orders of one size and times every phase of the pipeline on them, in the order main runs them.
+ * process_orders is measured through simulate_orders with a silent scheduler, so printing does not skew it.
+ * @return Returns the number of phases measured, 0 if the orders could not be generated.
+ */
+static int run_size(struct BenchOptions *options, long long size, struct PhaseResult *results) {
+    int count = 0, total_customers;
+    double start;
+    FILE *info_file_ptr, *orders_file_ptr = tmpfile();
+    struct SystemInfo system = {0};
+    struct ModelCatalog catalog;
+    struct ModelOrderingStats ordering_stats;
+    struct Order *orders;
+    struct ItemSoldStats *item_sold_stats;
+    struct InternTable customers;
+    struct OrderColumns columns;
+    struct DailyAggregates daily_aggregates;
+    struct TwelveMonthStats twelve_month_stats = {0};
+    struct SimulationResult simulation;
+    struct Scheduler scheduler;
+    struct Stock stock;
+
+    if ((info_file_ptr = fopen(options->info_file_name, "r")) == NULL) {
+        fprintf(stderr, "Error! opening file %s\n", options->info_file_name);
+        return 0;
+    }
+    model_catalog_init(&catalog);
+    extract_system_info(info_file_ptr, &system);
+    extract_models_info(info_file_ptr, &catalog);
+    fclose(info_file_ptr);
+    system.average_product_size = average_product_size(&catalog);
+
+    options->generator.orders = size;
+    start = now_seconds();
+    if (orders_file_ptr == NULL || order_generator_write(orders_file_ptr, &options->generator, &catalog) != 0) {
+        fprintf(stderr, "Error! writing the generated orders\n");
+        return 0;
+    }
+    rewind(orders_file_ptr);
+    results[count++] = (struct PhaseResult){"generate", now_seconds() - start, peak_rss_kb()};
+
+    intern_table_init(&customers);
+    ordering_stats_init(&ordering_stats, catalog.count);
+    start = now_seconds();
+    ordering_stats.total_orders = extract_orders_info(orders_file_ptr, &orders, &ordering_stats, &catalog, &customers);
+    results[count++] = (struct PhaseResult){"extract_orders_info", now_seconds() - start, peak_rss_kb()};
+    fclose(orders_file_ptr);
+
+    start = now_seconds();
+    sort_by_priority(orders, &catalog, ordering_stats.total_orders);
+    results[count++] = (struct PhaseResult){"sort_by_priority", now_seconds() - start, peak_rss_kb()};
+
+    start = now_seconds();
+    stock_init(&stock, system.storage_capacity, catalog.models, catalog.count);
+    scheduler_init(&scheduler, 1, NULL);
+    scheduler.policy = options->policy;
+    simulate_orders(orders, ordering_stats.total_orders, &ordering_stats, &system, &stock, &catalog, &scheduler, &simulation);
+    scheduler_free(&scheduler);
+    simulation_result_free(&simulation);
+    stock_free(&stock);
+    results[count++] = (struct PhaseResult){"process_orders", now_seconds() - start, peak_rss_kb()};
+
+    start = now_seconds();
+    total_customers = calculate_items_sold_for_each_customer(orders, &item_sold_stats, &customers, ordering_stats.total_orders, catalog.count);
+    results[count++] = (struct PhaseResult){"calculate_items_sold_for_each_customer", now_seconds() - start, peak_rss_kb()};
+    (void)total_customers;
+
+    start = now_seconds();
+    sort_by_day(orders, ordering_stats.total_orders);
+    results[count++] = (struct PhaseResult){"sort_by_day", now_seconds() - start, peak_rss_kb()};
+
+    start = now_seconds();
+    daily_aggregates_init(&daily_aggregates, catalog.models, catalog.count);
+    order_columns_build(&columns, orders, ordering_stats.total_orders, catalog.count);
+    daily_aggregates_build(&daily_aggregates, &columns);
+    order_columns_free(&columns);
+    calculate_twelve_month_stats(&daily_aggregates, &twelve_month_stats);
+    results[count++] = (struct PhaseResult){"calculate_twelve_month_stats", now_seconds() - start, peak_rss_kb()};
+
+    daily_aggregates_free(&daily_aggregates);
+    free(item_sold_stats);
+    free(orders);
+    ordering_stats_free(&ordering_stats);
+    model_catalog_free(&catalog);
+    intern_table_free(&customers);
+    return count;
+}
+
+/**
+ * Writes the timings of one size, one row per phase.
+ */
+static void write_results(struct BenchOptions *options, long long size, struct PhaseResult *results, int count, bool first) {
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        double throughput = results[i].seconds > 0 ? size / results[i].seconds : 0;
+
+        if (options->json) {
+            printf("%s\n  {\"orders\": %lld, \"phase\": \"%s\", \"seconds\": %.6f, \"orders_per_second\": %.0f, \"max_rss_kb\": %ld}",
+                   first && i == 0 ? "" : ",", size, results[i].phase, results[i].seconds, throughput, results[i].max_rss_kb);
+        } else {
+            printf("%lld,%s,%.6f,%.0f,%ld\n", size, results[i].phase, results[i].seconds, throughput, results[i].max_rss_kb);
+        }
+    }
+}
+
+/**
+ * Benchmarks every phase of the pipeline on generated orders of growing size.
+ * Usage: ./order_bench [--sizes n1,n2,...] [--json] [--info info.dat] [--policy fcfs|spt|margin] [generator options]
+ * Each size runs in its own process, so the peak resident set size reported belongs to that size alone.
+ * @return Return 0 if every run completed.
+ */
+int main(int argc, char **argv) {
+    int s, status = 0;
+    struct BenchOptions options;
+
+    parse_bench_options(argc, argv, &options);
+
+    if (options.json) {
+        printf("[");
+    } else {
+        printf("orders,phase,seconds,orders_per_second,max_rss_kb\n");
+    }
+    fflush(stdout);
+
+    for (s = 0; s < options.size_count; ++s) {
+        pid_t child = fork();
+
+        if (child == 0) {
+            struct PhaseResult results[16];
+            int count = run_size(&options, options.sizes[s], results);
+
+            write_results(&options, options.sizes[s], results, count, s == 0);
+            fflush(stdout);
+            _exit(count > 0 ? 0 : 1);
+        }
+        if (child < 0 || waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "Error! run of %lld orders failed\n", options.sizes[s]);
+            status = 1;
+            break;
+        }
+        status = 0;
+    }
+
+    if (options.json) {
+        printf("\n]\n");
+    }
+    return status;
+}
@@ -0,0 +1,53 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "order_system.h"
+#include "order_store.h"
+#include "order_file.h"
+
+/**
+ * Converts info.dat and an orders file in the text layout into a binary order file.
+ * Usage: ./order_convert info.dat orders.dat orders.bin
+ * @return Return 0 if the file was converted successfully.
+ */
+int main(int argc, char **argv) {
+    int total_orders;
+    FILE *info_file_ptr, *orders_file_ptr;
+    struct SystemInfo system = {0};
+    struct ModelCatalog catalog;
+    struct ModelOrderingStats ordering_stats;
+    struct Order *orders;
+    struct InternTable customers;
+    struct OrderColumns columns;
+
+    if (argc != 4) {
+        printf("Usage: %s info.dat orders.dat orders.bin\n", argv[0]);
+        return 1;
+    }
+
+    read_file(&info_file_ptr, argv[1]);
+    model_catalog_init(&catalog);
+    extract_system_info(info_file_ptr, &system);
+    extract_models_info(info_file_ptr, &catalog);
+    fclose(info_file_ptr);
+
+    read_file(&orders_file_ptr, argv[2]);
+    intern_table_init(&customers);
+    ordering_stats_init(&ordering_stats, catalog.count);
+    total_orders = extract_orders_info_parallel(orders_file_ptr, &orders, &ordering_stats, &catalog, &customers, 0);
+    fclose(orders_file_ptr);
+
+    order_columns_build(&columns, orders, total_orders, catalog.count);
+    if (order_file_write(argv[3], &system, &catalog, &columns, &customers) != 0) {
+        return 1;
+    }
+    printf("Converted %d orders of %d customers into %s\n", total_orders, customers.count, argv[3]);
+
+    order_columns_free(&columns);
+    ordering_stats_free(&ordering_stats);
+    model_catalog_free(&catalog);
+    intern_table_free(&customers);
+    free(orders);
+    return 0;
+}
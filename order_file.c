@@ -0,0 +1,313 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "order_file.h"
+
+/**
+ * Rounds an offset up to the alignment of the file sections.
+ * @param offset Offset in the file.
+ * @return Returns the first multiple of ORDER_FILE_ALIGNMENT not below offset.
+ */
+uint64_t order_file_align(uint64_t offset) {
+    return (offset + ORDER_FILE_ALIGNMENT - 1) / ORDER_FILE_ALIGNMENT * ORDER_FILE_ALIGNMENT;
+}
+
+/**
+ * Tells whether the file is a binary order file, by looking at its magic.
+ * @param name File name
+ * @return True if the file starts with ORDER_FILE_MAGIC.
+ */
+bool order_file_is_binary(char *name) {
+    char magic[8] = {0};
+    FILE *fptr = fopen(name, "rb");
+
+    if (fptr == NULL) {
+        return false;
+    }
+    if (fread(magic, 1, sizeof(magic), fptr) != sizeof(magic)) {
+        magic[0] = '\0';
+    }
+    fclose(fptr);
+    return memcmp(magic, ORDER_FILE_MAGIC, sizeof(ORDER_FILE_MAGIC)) == 0;
+}
+
+/**
+ * Writes a section at the given offset, padding the file with zeros up to it. Sections must be written in the order
+ * of their offsets.
+ * @param fptr File being written.
+ * @param offset Offset of the section, at or after the current position.
+ * @param data Content of the section.
+ * @param size Size of the section in bytes.
+ * @return Returns 0 on success, -1 if the file could not be written.
+ */
+int order_file_write_section(FILE *fptr, uint64_t offset, const void *data, size_t size) {
+    static const char zeros[ORDER_FILE_ALIGNMENT] = {0};
+    long position = ftell(fptr);
+
+    if (position < 0 || (uint64_t)position > offset) {
+        return -1;
+    }
+    if (fwrite(zeros, 1, (size_t)(offset - (uint64_t)position), fptr) != (size_t)(offset - (uint64_t)position)) {
+        return -1;
+    }
+    return size == 0 || fwrite(data, 1, size, fptr) == size ? 0 : -1;
+}
+
+/**
+ * Builds the model table of a binary file from the catalog.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @return Returns the table, one entry per model id, to be released with free. NULL if there is not enough memory.
+ */
+struct OrderFileModel *order_file_model_table(struct ModelCatalog *catalog) {
+    int i;
+    struct OrderFileModel *table = calloc(catalog->count > 0 ? catalog->count : 1, sizeof(struct OrderFileModel));
+
+    for (i = 0; table != NULL && i < catalog->count; ++i) {
+        memcpy(table[i].model, catalog->models[i].model, MODEL_NAME_LENGTH);
+        table[i].cost = catalog->models[i].cost;
+        table[i].price = catalog->models[i].price;
+        table[i].man_hours = catalog->models[i].man_hours;
+        table[i].space_required = catalog->models[i].space_required;
+    }
+    return table;
+}
+
+/**
+ * Adds the models of a binary file table to an empty catalog, so that they keep the ids of the file.
+ * @param table Model table of the file.
+ * @param count Number of entries of the table.
+ * @param catalog Pointer reference to an empty ModelCatalog struct receiving the models.
+ */
+void order_file_add_models(const struct OrderFileModel *table, int count, struct ModelCatalog *catalog) {
+    int i;
+    struct ModelInfo model;
+
+    for (i = 0; i < count; ++i) {
+        memcpy(model.model, table[i].model, MODEL_NAME_LENGTH);
+        model.model[MODEL_NAME_LENGTH - 1] = '\0';
+        model.cost = table[i].cost;
+        model.price = table[i].price;
+        model.man_hours = table[i].man_hours;
+        model.space_required = table[i].space_required;
+        if (model_catalog_add(catalog, &model) != i) {
+            printf("Error! model %s defined twice in the file\n", model.model);
+            exit(0);
+        }
+    }
+}
+
+/**
+ * Writes orders, system and model information into a binary order file.
+ * @param name File name
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param columns Pointer reference to the OrderColumns struct holding the orders.
+ * @param customers Pointer reference to the customer InternTable.
+ * @return Returns 0 on success, -1 if the file could not be written.
+ */
+int order_file_write(char *name, struct SystemInfo *system, struct ModelCatalog *catalog, struct OrderColumns *columns, struct InternTable *customers) {
+    int i, status = 0;
+    size_t column_size = (size_t)columns->count * sizeof(int32_t);
+    size_t table_size = (size_t)catalog->count * sizeof(struct OrderFileModel);
+    struct OrderFileHeader header;
+    struct OrderFileModel *table = order_file_model_table(catalog);
+    uint64_t *name_offsets = malloc((customers->count > 0 ? customers->count : 1) * sizeof(uint64_t));
+    FILE *fptr = fopen(name, "wb");
+
+    if (fptr == NULL || name_offsets == NULL || table == NULL) {
+        printf("Error! writing file %s\n", name);
+        free(name_offsets);
+        free(table);
+        if (fptr != NULL) {
+            fclose(fptr);
+        }
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ORDER_FILE_MAGIC, sizeof(ORDER_FILE_MAGIC));
+    header.version = ORDER_FILE_VERSION;
+    header.flags = ORDER_FILE_SORTED;
+    header.storage_capacity = system->storage_capacity;
+    header.number_of_workers = system->number_of_workers;
+    header.model_count = catalog->count;
+    header.customer_count = customers->count;
+    header.order_count = columns->count;
+    header.min_timestamp = columns->count > 0 ? columns->timestamp[0] : 0;
+    header.max_timestamp = header.min_timestamp;
+    for (i = 0; i < columns->count; ++i) {
+        if (columns->timestamp[i] < header.min_timestamp) header.min_timestamp = columns->timestamp[i];
+        if (columns->timestamp[i] > header.max_timestamp) header.max_timestamp = columns->timestamp[i];
+        if (i > 0 && columns->timestamp[i] < columns->timestamp[i - 1]) header.flags &= ~ORDER_FILE_SORTED;
+    }
+
+    for (i = 0; i < customers->count; ++i) {
+        name_offsets[i] = customers->offsets[i];
+    }
+
+    header.models_offset = order_file_align(sizeof(header));
+    header.timestamp_offset = order_file_align(header.models_offset + table_size);
+    header.model_id_offset = order_file_align(header.timestamp_offset + column_size);
+    header.quantity_offset = order_file_align(header.model_id_offset + column_size);
+    header.customer_id_offset = order_file_align(header.quantity_offset + column_size);
+    header.customer_names_offset = order_file_align(header.customer_id_offset + column_size);
+    header.customer_names_size = customers->arena_length;
+    header.file_size = header.customer_names_offset + customers->count * sizeof(uint64_t) + customers->arena_length;
+
+    status |= order_file_write_section(fptr, 0, &header, sizeof(header));
+    status |= order_file_write_section(fptr, header.models_offset, table, table_size);
+    status |= order_file_write_section(fptr, header.timestamp_offset, columns->timestamp, column_size);
+    status |= order_file_write_section(fptr, header.model_id_offset, columns->model_id, column_size);
+    status |= order_file_write_section(fptr, header.quantity_offset, columns->quantity, column_size);
+    status |= order_file_write_section(fptr, header.customer_id_offset, columns->customer_id, column_size);
+    status |= order_file_write_section(fptr, header.customer_names_offset, name_offsets, customers->count * sizeof(uint64_t));
+    status |= order_file_write_section(fptr, header.customer_names_offset + customers->count * sizeof(uint64_t), customers->arena, customers->arena_length);
+
+    if (fclose(fptr) != 0 || status != 0) {
+        printf("Error! writing file %s\n", name);
+        status = -1;
+    }
+    free(name_offsets);
+    free(table);
+    return status;
+}
+
+/**
+ * Tells whether a section of the given size at the given offset is aligned and lies inside the file.
+ * @param offset Offset of the section.
+ * @param size Size of the section in bytes.
+ * @param file_size Size of the file.
+ * @return True if the section fits.
+ */
+bool order_file_section_fits(uint64_t offset, uint64_t size, uint64_t file_size) {
+    return offset % ORDER_FILE_ALIGNMENT == 0 && offset <= file_size && size <= file_size - offset;
+}
+
+/**
+ * Maps a binary order file in memory. Nothing is parsed or copied: the header is checked and the columns are
+ * pointed at the mapping, so the pages are only read when they are first used.
+ * @param name File name
+ * @param file Pointer reference to the MappedOrderFile struct to fill.
+ * @return Returns 0 on success, -1 if the file can not be mapped or is not a valid order file.
+ */
+int order_file_map(char *name, struct MappedOrderFile *file) {
+    int fd = open(name, O_RDONLY);
+    struct stat info;
+    const struct OrderFileHeader *header;
+    uint64_t column_size, names_size;
+    char *data;
+
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(struct OrderFileHeader)) {
+        printf("Error! opening file %s\n", name);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Error! mapping file %s\n", name);
+        return -1;
+    }
+
+    header = (const struct OrderFileHeader *)data;
+    column_size = (uint64_t)header->order_count * sizeof(int32_t);
+    names_size = (uint64_t)header->customer_count * sizeof(uint64_t) + header->customer_names_size;
+    if (memcmp(header->magic, ORDER_FILE_MAGIC, sizeof(ORDER_FILE_MAGIC)) != 0
+        || header->version != ORDER_FILE_VERSION
+        || header->file_size != (uint64_t)info.st_size
+        || header->model_count < 0
+        || header->order_count < 0 || header->order_count > INT32_MAX || header->customer_count < 0
+        || !order_file_section_fits(header->models_offset, header->model_count * sizeof(struct OrderFileModel), header->file_size)
+        || !order_file_section_fits(header->timestamp_offset, column_size, header->file_size)
+        || !order_file_section_fits(header->model_id_offset, column_size, header->file_size)
+        || !order_file_section_fits(header->quantity_offset, column_size, header->file_size)
+        || !order_file_section_fits(header->customer_id_offset, column_size, header->file_size)
+        || !order_file_section_fits(header->customer_names_offset, names_size, header->file_size)
+        || (header->customer_names_size > 0 && data[header->file_size - 1] != '\0')) {
+        printf("Error! %s is not a valid order file\n", name);
+        munmap(data, (size_t)info.st_size);
+        return -1;
+    }
+
+    file->data = data;
+    file->size = (size_t)info.st_size;
+    file->header = header;
+    file->models = (const struct OrderFileModel *)(data + header->models_offset);
+    file->columns.timestamp = (int *)(data + header->timestamp_offset);
+    file->columns.model_id = (int *)(data + header->model_id_offset);
+    file->columns.quantity = (int *)(data + header->quantity_offset);
+    file->columns.customer_id = (int *)(data + header->customer_id_offset);
+    file->columns.count = (int)header->order_count;
+    file->columns.capacity = (int)header->order_count;
+    file->customer_name_offsets = (const uint64_t *)(data + header->customer_names_offset);
+    file->customer_names = data + header->customer_names_offset + header->customer_count * sizeof(uint64_t);
+    return 0;
+}
+
+/**
+ * Unmaps a binary order file.
+ * @param file Pointer reference to the MappedOrderFile struct.
+ */
+void order_file_unmap(struct MappedOrderFile *file) {
+    munmap(file->data, file->size);
+    file->data = NULL;
+}
+
+/**
+ * Copies the system and model information stored in the file header. The models keep the ids of the file.
+ * @param file Pointer reference to the MappedOrderFile struct.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param catalog Pointer reference to an empty ModelCatalog struct receiving the models.
+ */
+void order_file_system_info(struct MappedOrderFile *file, struct SystemInfo *system, struct ModelCatalog *catalog) {
+    system->storage_capacity = file->header->storage_capacity;
+    system->number_of_workers = file->header->number_of_workers;
+    order_file_add_models(file->models, file->header->model_count, catalog);
+}
+
+/**
+ * Builds the Order structs used by the simulation from the columns of the file. The records are copied once,
+ * since the simulation sorts and rewrites them; only the twelve month statistics read the mapped columns directly.
+ * A model or customer id outside the tables of the file becomes -1.
+ * @param file Pointer reference to the MappedOrderFile struct.
+ * @param orders Pointer to the array of Order structs, allocated by this function.
+ * @param stats Pointer to ModelOrderingStats struct, sized for the models of the file.
+ * @param customers Pointer to the InternTable which receives the customer names, with the ids of the file.
+ * @return Returns the number of orders.
+ */
+int order_file_orders(struct MappedOrderFile *file, struct Order **orders, struct ModelOrderingStats *stats, struct InternTable *customers) {
+    int i, count = file->columns.count;
+    struct Order *list = calloc(count > 0 ? count : 1, sizeof(struct Order));
+
+    if (list == NULL) {
+        printf("Error! not enough memory for %d orders\n", count);
+        exit(0);
+    }
+    for (i = 0; i < file->header->customer_count; ++i) {
+        const char *name = "";
+        if (file->customer_name_offsets[i] < file->header->customer_names_size) {
+            name = file->customer_names + file->customer_name_offsets[i];
+        }
+        intern_table_id(customers, name, strlen(name));
+    }
+
+    for (i = 0; i < count; ++i) {
+        int model_id = file->columns.model_id[i], customer_id = file->columns.customer_id[i];
+
+        list[i].timestamp = file->columns.timestamp[i];
+        list[i].model_id = model_id >= 0 && model_id < file->header->model_count ? model_id : -1;
+        list[i].quantity = file->columns.quantity[i];
+        list[i].customer_id = customer_id >= 0 && customer_id < file->header->customer_count ? customer_id : -1;
+        update_ordering_stats(list[i].model_id, stats);
+    }
+
+    *orders = list;
+    return count;
+}
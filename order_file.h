@@ -0,0 +1,75 @@
+#ifndef ORDER_SYSTEM_ORDER_FILE_H
+#define ORDER_SYSTEM_ORDER_FILE_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "order_system.h"
+#include "order_store.h"
+#define ORDER_FILE_MAGIC "COFFORD"
+#define ORDER_FILE_VERSION 2
+#define ORDER_FILE_ALIGNMENT 64
+#define ORDER_FILE_SORTED 1
+/** @file */
+
+/**
+ * Model entry of a binary order file.
+ */
+struct OrderFileModel {
+    char model[MODEL_NAME_LENGTH]; /**< Name of the item model, null terminated. */
+    float cost; /**< Cost for the manufacturing of the item model. */
+    float price; /**< Sale price of the item model. */
+    int32_t man_hours; /**< Man hours required to manufacture the item model. */
+    int32_t space_required; /**< Space required to stack 1 item of this model. */
+};
+
+/**
+ * Header at the start of a binary order file. Every offset is counted from the start of the file and is aligned
+ * to ORDER_FILE_ALIGNMENT bytes. The columns hold order_count 32 bit integers each.
+ */
+struct OrderFileHeader {
+    char magic[8]; /**< ORDER_FILE_MAGIC, null terminated. */
+    uint32_t version; /**< ORDER_FILE_VERSION. */
+    uint32_t flags; /**< ORDER_FILE_SORTED when the orders are sorted by timestamp. */
+    uint64_t file_size; /**< Total size of the file, to detect truncated files. */
+    int32_t storage_capacity; /**< Stock capacity in m^3, from info.dat. */
+    int32_t number_of_workers; /**< Number of workers available, from info.dat. */
+    int32_t model_count; /**< Number of entries of the model table. */
+    int32_t customer_count; /**< Number of entries of the customer string table. */
+    int64_t order_count; /**< Number of orders. */
+    int32_t min_timestamp; /**< Earliest order time. */
+    int32_t max_timestamp; /**< Latest order time. */
+    uint64_t models_offset; /**< Offset of the model table, which the model ids index. */
+    uint64_t timestamp_offset; /**< Offset of the timestamp column. */
+    uint64_t model_id_offset; /**< Offset of the model id column. */
+    uint64_t quantity_offset; /**< Offset of the quantity column. */
+    uint64_t customer_id_offset; /**< Offset of the customer id column. */
+    uint64_t customer_names_offset; /**< Offset of the customer string table (offset array followed by the names). */
+    uint64_t customer_names_size; /**< Size in bytes of the null terminated names. */
+};
+
+/**
+ * Binary order file mapped in memory. The columns and names point straight into the mapping and are read only.
+ */
+struct MappedOrderFile {
+    void *data; /**< Start of the mapping. */
+    size_t size; /**< Size of the mapping. */
+    const struct OrderFileHeader *header; /**< Header of the file. */
+    const struct OrderFileModel *models; /**< Model table. */
+    struct OrderColumns columns; /**< Columns pointing into the mapping, must not be freed or written. */
+    const uint64_t *customer_name_offsets; /**< Offset of each customer name in customer_names. */
+    const char *customer_names; /**< Null terminated customer names. */
+};
+
+uint64_t order_file_align(uint64_t);
+int order_file_write_section(FILE *, uint64_t, const void *, size_t);
+bool order_file_section_fits(uint64_t, uint64_t, uint64_t);
+bool order_file_is_binary(char *);
+struct OrderFileModel *order_file_model_table(struct ModelCatalog *);
+void order_file_add_models(const struct OrderFileModel *, int, struct ModelCatalog *);
+int order_file_write(char *, struct SystemInfo *, struct ModelCatalog *, struct OrderColumns *, struct InternTable *);
+int order_file_map(char *, struct MappedOrderFile *);
+void order_file_unmap(struct MappedOrderFile *);
+void order_file_system_info(struct MappedOrderFile *, struct SystemInfo *, struct ModelCatalog *);
+int order_file_orders(struct MappedOrderFile *, struct Order **, struct ModelOrderingStats *, struct InternTable *);
+
+#endif //ORDER_SYSTEM_ORDER_FILE_H
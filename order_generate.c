@@ -0,0 +1,58 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "order_generator.h"
+
+/**
+ * Writes a synthetic orders file in the orders.dat layout.
+ * Usage: ./order_generate [--info info.dat] [--orders count] [--customers count] [--mix a,b,c,d] [--gap days]
+ * [--burst count] [--quantity count] [--seed value] [output file]
+ * The model names come from the info file. Without an output file the orders are written to the standard output.
+ * @return Return 0 if the file was written successfully.
+ */
+int main(int argc, char **argv) {
+    int i;
+    char *output_file_name = NULL, *info_file_name = "info.dat";
+    FILE *fptr = stdout, *info_file_ptr;
+    struct GeneratorOptions options;
+    struct SystemInfo system;
+    struct ModelCatalog catalog;
+
+    generator_options_init(&options);
+    for (i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-' && i + 1 < argc && strcmp(argv[i], "--info") == 0) {
+            info_file_name = argv[++i];
+            continue;
+        }
+        if (argv[i][0] == '-' && (i + 1 >= argc || generator_options_parse(&options, argv[i], argv[i + 1]) != 0)) {
+            printf("Usage: %s [--info info.dat] [--orders count] [--customers count] [--mix a,b,c,d] [--gap days] [--burst count] [--quantity count] [--seed value] [output file]\n", argv[0]);
+            return 1;
+        }
+        if (argv[i][0] == '-') {
+            ++i;
+        } else {
+            output_file_name = argv[i];
+        }
+    }
+
+    if ((info_file_ptr = fopen(info_file_name, "r")) == NULL) {
+        fprintf(stderr, "Error! opening file %s\n", info_file_name);
+        return 1;
+    }
+    model_catalog_init(&catalog);
+    extract_system_info(info_file_ptr, &system);
+    extract_models_info(info_file_ptr, &catalog);
+    fclose(info_file_ptr);
+
+    if (output_file_name != NULL && (fptr = fopen(output_file_name, "w")) == NULL) {
+        printf("Error! opening file %s\n", output_file_name);
+        return 1;
+    }
+    if (order_generator_write(fptr, &options, &catalog) != 0 || (output_file_name != NULL && fclose(fptr) != 0)) {
+        fprintf(stderr, "Error! writing the orders, check that the mix has at most %d weights\n", catalog.count);
+        return 1;
+    }
+    model_catalog_free(&catalog);
+    return 0;
+}
@@ -0,0 +1,155 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "order_generator.h"
+
+/**
+ * Next value of a xorshift64* generator.
+ */
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+/**
+ * Random value between 0 and bound - 1.
+ */
+static int random_below(uint64_t *state, int bound) {
+    return bound > 1 ? (int)(next_random(state) % (uint64_t)bound) : 0;
+}
+
+/**
+ * Reads a comma separated list of weights. Models missing from the end of the list get a weight of 0.
+ * @return Returns the sum of the weights, -1 for an invalid list or more weights than slots.
+ */
+static long long parse_mix(const char *value, int *weights, int slots) {
+    int m = 0;
+    long long total = 0;
+
+    while (*value != '\0') {
+        char *end;
+        long weight = strtol(value, &end, 10);
+
+        if (end == value || weight < 0 || weight > 1000000 || (*end != ',' && *end != '\0') || (weights != NULL && m == slots)) {
+            return -1;
+        }
+        if (weights != NULL) {
+            weights[m] = (int)weight;
+        }
+        total += weight;
+        ++m;
+        value = *end == ',' ? end + 1 : end;
+    }
+    return total;
+}
+
+/**
+ * Sets the defaults: a thousand orders of a hundred customers, the first model of the catalog weighted the most
+ * (4:3:2:1 for four models), gaps of up to 3 days and bursts of up to 4 orders of up to 5 items.
+ * @param options Pointer reference to the GeneratorOptions struct.
+ */
+void generator_options_init(struct GeneratorOptions *options) {
+    options->orders = 1000;
+    options->customers = 100;
+    options->model_mix = NULL;
+    options->max_gap = 3;
+    options->max_burst = 4;
+    options->max_quantity = 5;
+    options->seed = 1;
+}
+
+/**
+ * Sets one option from its command line name and value.
+ * @param options Pointer reference to the GeneratorOptions struct.
+ * @param name Option name: --orders, --customers, --mix, --gap, --burst, --quantity or --seed.
+ * @param value Option value, the mix is given as comma separated weights in the order of the catalog.
+ * @return Returns 0 on success, -1 for an unknown option or an invalid value.
+ */
+int generator_options_parse(struct GeneratorOptions *options, char *name, char *value) {
+    if (strcmp(name, "--orders") == 0) {
+        options->orders = atoll(value);
+        return options->orders >= 0 ? 0 : -1;
+    }
+    if (strcmp(name, "--customers") == 0) {
+        options->customers = atoi(value);
+        return options->customers > 0 && options->customers <= 9999999 ? 0 : -1;
+    }
+    if (strcmp(name, "--gap") == 0) {
+        options->max_gap = atoi(value);
+        return options->max_gap >= 0 ? 0 : -1;
+    }
+    if (strcmp(name, "--burst") == 0) {
+        options->max_burst = atoi(value);
+        return options->max_burst > 0 ? 0 : -1;
+    }
+    if (strcmp(name, "--quantity") == 0) {
+        options->max_quantity = atoi(value);
+        return options->max_quantity > 0 ? 0 : -1;
+    }
+    if (strcmp(name, "--seed") == 0) {
+        options->seed = strtoull(value, NULL, 10);
+        return 0;
+    }
+    if (strcmp(name, "--mix") == 0) {
+        options->model_mix = value;
+        return parse_mix(value, NULL, 0) > 0 ? 0 : -1;
+    }
+    return -1;
+}
+
+/**
+ * Writes random orders in the orders.dat layout. Timestamps never decrease: each burst of orders shares one
+ * timestamp and the next burst comes 0 to max_gap days later. Customers are named C0000000, C0000001, ...
+ * @param fptr File receiving the orders.
+ * @param options Pointer reference to the GeneratorOptions struct.
+ * @param catalog Pointer reference to the ModelCatalog struct giving the model names.
+ * @return Returns 0 on success, -1 if the mix does not fit the catalog or the file could not be written.
+ */
+int order_generator_write(FILE *fptr, struct GeneratorOptions *options, struct ModelCatalog *catalog) {
+    uint64_t state = options->seed != 0 ? options->seed : 1;
+    int m, timestamp = 1, burst_left = 0, status = 0;
+    int *mix;
+    long long i, total_mix = 0;
+
+    if (catalog->count == 0 || (mix = calloc(catalog->count, sizeof(int))) == NULL) {
+        return -1;
+    }
+    if (options->model_mix != NULL) {
+        total_mix = parse_mix(options->model_mix, mix, catalog->count);
+    } else {
+        for (m = 0; m < catalog->count; ++m) {
+            mix[m] = catalog->count - m;
+            total_mix += mix[m];
+        }
+    }
+    if (total_mix <= 0 || total_mix > 2147483647LL) {
+        free(mix);
+        return -1;
+    }
+
+    for (i = 0; i < options->orders; ++i) {
+        int pick, model = 0;
+
+        if (burst_left == 0) {
+            if (i > 0) {
+                timestamp += random_below(&state, options->max_gap + 1);
+            }
+            burst_left = 1 + random_below(&state, options->max_burst);
+        }
+        burst_left--;
+
+        pick = random_below(&state, (int)total_mix);
+        while (pick >= mix[model]) {
+            pick -= mix[model++];
+        }
+        if (fprintf(fptr, "%d %s %d C%07d\n", timestamp, catalog->models[model].model, 1 + random_below(&state, options->max_quantity), random_below(&state, options->customers)) < 0) {
+            status = -1;
+            break;
+        }
+    }
+    free(mix);
+    return status != 0 || ferror(fptr) ? -1 : 0;
+}
@@ -0,0 +1,26 @@
+#ifndef ORDER_SYSTEM_ORDER_GENERATOR_H
+#define ORDER_SYSTEM_ORDER_GENERATOR_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "order_system.h"
+/** @file */
+
+/**
+ * Shape of a synthetic orders file.
+ */
+struct GeneratorOptions {
+    long long orders; /**< Number of orders to write. */
+    int customers; /**< Number of distinct customers. */
+    char *model_mix; /**< Comma separated relative weight of each model of the catalog, NULL for the default mix. */
+    int max_gap; /**< Largest number of days between two consecutive timestamps. */
+    int max_burst; /**< Largest number of orders sharing the same timestamp. */
+    int max_quantity; /**< Largest quantity of an order. */
+    uint64_t seed; /**< Seed of the random generator, the same seed always gives the same file. */
+};
+
+void generator_options_init(struct GeneratorOptions *);
+int generator_options_parse(struct GeneratorOptions *, char *, char *);
+int order_generator_write(FILE *, struct GeneratorOptions *, struct ModelCatalog *);
+
+#endif //ORDER_SYSTEM_ORDER_GENERATOR_H
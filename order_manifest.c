@@ -0,0 +1,297 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "order_manifest.h"
+
+/**
+ * Continues a 64 bit FNV-1a hash over some bytes. Hashing a file in pieces gives the same value as hashing it whole.
+ * @param data Bytes to hash.
+ * @param length Number of bytes.
+ * @param hash Hash of the bytes before, ORDER_MANIFEST_HASH_SEED to start.
+ * @return Returns the hash including the new bytes.
+ */
+uint64_t order_manifest_hash(const char *data, size_t length, uint64_t hash) {
+    size_t i;
+
+    for (i = 0; i < length; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Checks that an orders file still starts with the part consumed by a manifest: it must be at least as long, and the
+ * whole of that part must keep its hash. This reads every byte consumed, but only hashes them, which is much cheaper
+ * than parsing and simulating them again.
+ * @param data Start of the orders file.
+ * @param size Size of the orders file.
+ * @param manifest Pointer reference to the OrderManifest struct.
+ * @return Returns true if the consumed part is unchanged.
+ */
+bool order_manifest_prefix_matches(const char *data, size_t size, struct OrderManifest *manifest) {
+    if (manifest->orders_offset > size) {
+        return false;
+    }
+    return order_manifest_hash(data, manifest->orders_offset, ORDER_MANIFEST_HASH_SEED) == manifest->prefix_hash;
+}
+
+/**
+ * Hashes a whole file with order_manifest_hash.
+ * @param name File name
+ * @param hash Pointer receiving the hash.
+ * @return Returns 0 on success, -1 if the file can not be read.
+ */
+int order_manifest_hash_file(char *name, uint64_t *hash) {
+    char buffer[1 << 14];
+    size_t length;
+    FILE *fptr = fopen(name, "rb");
+
+    if (fptr == NULL) {
+        return -1;
+    }
+    *hash = ORDER_MANIFEST_HASH_SEED;
+    while ((length = fread(buffer, 1, sizeof(buffer), fptr)) > 0) {
+        *hash = order_manifest_hash(buffer, length, *hash);
+    }
+    fclose(fptr);
+    return 0;
+}
+
+/**
+ * Reads a manifest and its items sold table, and checks its magic, version and size.
+ * @param name File name
+ * @param manifest Pointer reference to the OrderManifest struct to fill.
+ * @param items_sold Pointer receiving the items sold table, to free.
+ * @return Returns 0 on success, -1 if the file is missing or is not a manifest of this version.
+ */
+int order_manifest_read(char *name, struct OrderManifest *manifest, int32_t **items_sold) {
+    FILE *fptr = fopen(name, "rb");
+    size_t read, cells;
+
+    *items_sold = NULL;
+    if (fptr == NULL) {
+        return -1;
+    }
+    read = fread(manifest, sizeof(*manifest), 1, fptr);
+    if (read != 1 || memcmp(manifest->magic, ORDER_MANIFEST_MAGIC, sizeof(ORDER_MANIFEST_MAGIC)) != 0
+        || manifest->version != ORDER_MANIFEST_VERSION || manifest->order_count < 0
+        || manifest->lines < 0 || manifest->customer_count < 0 || manifest->model_count < 0) {
+        fclose(fptr);
+        return -1;
+    }
+    cells = (size_t)manifest->customer_count * manifest->model_count;
+    *items_sold = malloc((cells > 0 ? cells : 1) * sizeof(int32_t));
+    if (*items_sold == NULL || fread(*items_sold, sizeof(int32_t), cells, fptr) != cells || fgetc(fptr) != EOF) {
+        fclose(fptr);
+        free(*items_sold);
+        *items_sold = NULL;
+        return -1;
+    }
+    fclose(fptr);
+    return 0;
+}
+
+/**
+ * Writes a manifest followed by its items sold table, filling its magic and version. As for snapshots, the file is
+ * written next to its final name and renamed once complete.
+ * @param name File name
+ * @param manifest Pointer reference to the OrderManifest struct.
+ * @param items_sold Number of orders of each model placed by each customer, customer_count rows of model_count.
+ * @return Returns 0 on success, -1 if the file could not be written.
+ */
+int order_manifest_write(char *name, struct OrderManifest *manifest, const int32_t *items_sold) {
+    size_t temporary_length = strlen(name) + 5;
+    size_t cells = (size_t)manifest->customer_count * manifest->model_count;
+    char *temporary_name = malloc(temporary_length);
+    FILE *fptr = NULL;
+    int status = 0;
+
+    memset(manifest->magic, 0, sizeof(manifest->magic));
+    memcpy(manifest->magic, ORDER_MANIFEST_MAGIC, sizeof(ORDER_MANIFEST_MAGIC));
+    manifest->version = ORDER_MANIFEST_VERSION;
+    if (temporary_name != NULL) {
+        snprintf(temporary_name, temporary_length, "%s.tmp", name);
+        fptr = fopen(temporary_name, "wb");
+    }
+    if (fptr == NULL) {
+        printf("Error! writing file %s\n", name);
+        free(temporary_name);
+        return -1;
+    }
+    if (fwrite(manifest, sizeof(*manifest), 1, fptr) != 1 || fwrite(items_sold, sizeof(int32_t), cells, fptr) != cells) {
+        status = -1;
+    }
+    if (fclose(fptr) != 0 || status != 0 || rename(temporary_name, name) != 0) {
+        printf("Error! writing file %s\n", name);
+        remove(temporary_name);
+        status = -1;
+    }
+    free(temporary_name);
+    return status;
+}
+
+/**
+ * Writes orders to the history file of an incremental run, raw Order records in the order they were simulated,
+ * starting at the given record. Records left past the new end by a run which stopped before saving its manifest are
+ * cut, so only the records of the manifest and the new ones remain.
+ * @param name File name
+ * @param orders Pointer reference to the array of Order structs to write.
+ * @param first Position of the first record to write, the number of orders of the manifest.
+ * @param count Number of orders.
+ * @return Returns 0 on success, -1 if the file could not be written.
+ */
+int order_manifest_write_history(char *name, const struct Order *orders, int first, int count) {
+    int fd = open(name, O_WRONLY | O_CREAT, 0644);
+    off_t offset = (off_t)first * sizeof(struct Order);
+    size_t length = (size_t)count * sizeof(struct Order), written = 0;
+    ssize_t result;
+
+    if (fd < 0) {
+        printf("Error! writing file %s\n", name);
+        return -1;
+    }
+    while (written < length && (result = pwrite(fd, (const char *)orders + written, length - written, offset + (off_t)written)) > 0) {
+        written += (size_t)result;
+    }
+    if (written < length || ftruncate(fd, offset + (off_t)length) != 0 || close(fd) != 0) {
+        printf("Error! writing file %s\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Checks that a history file holds at least the records of a manifest.
+ * @param name File name
+ * @param count Number of records of the manifest.
+ * @return Returns true if the file holds count records or more.
+ */
+bool order_manifest_history_holds(char *name, int count) {
+    struct stat info;
+
+    return stat(name, &info) == 0 && (uint64_t)info.st_size >= (uint64_t)count * sizeof(struct Order);
+}
+
+/**
+ * Maps the first records of a history file in memory, read only, for the reports over the whole history.
+ * @param name File name
+ * @param count Number of records of the manifest.
+ * @return Returns the records, NULL if the file is missing or holds fewer records.
+ */
+const struct Order *order_manifest_map_history(char *name, int count) {
+    static const struct Order empty;
+    size_t length = (size_t)count * sizeof(struct Order);
+    int fd = open(name, O_RDONLY);
+    struct stat info;
+    void *data;
+
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < length) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+    if (length == 0) {
+        close(fd);
+        return &empty;
+    }
+    data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return data == MAP_FAILED ? NULL : data;
+}
+
+/**
+ * Releases a mapping made by order_manifest_map_history.
+ * @param orders Start of the mapping.
+ * @param count Number of records mapped.
+ */
+void order_manifest_unmap_history(const struct Order *orders, int count) {
+    if (count > 0) {
+        munmap((void *)orders, (size_t)count * sizeof(struct Order));
+    }
+}
+
+/**
+ * Maps a whole orders file in memory, read only, so that the blocks of the consumed part can be hashed and the new
+ * part parsed without copying either.
+ * @param name File name
+ * @param size Pointer receiving the size of the file.
+ * @return Returns the start of the mapping, an empty string for an empty file.
+ */
+const char *order_manifest_map_orders(char *name, size_t *size) {
+    int fd = open(name, O_RDONLY);
+    struct stat info;
+    char *data;
+
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        printf("Error! opening file %s\n", name);
+        exit(0);
+    }
+    *size = (size_t)info.st_size;
+    if (*size == 0) {
+        close(fd);
+        return "";
+    }
+    data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Error! mapping file %s\n", name);
+        exit(0);
+    }
+    return data;
+}
+
+/**
+ * Releases a mapping made by order_manifest_map_orders.
+ * @param data Start of the mapping.
+ * @param size Size of the file.
+ */
+void order_manifest_unmap_orders(const char *data, size_t size) {
+    if (size > 0) {
+        munmap((void *)data, size);
+    }
+}
+
+/**
+ * Checks that no line of some new bytes of an orders file starts with a timestamp before the given one, reading only
+ * the number at the start of each line. Orders of the latest day consumed may still be appended; they are simulated
+ * after the orders of that day read before. Lines which do not start with a number are left to the parser, which
+ * reports the malformed ones.
+ * @param begin First byte, at the start of a line.
+ * @param end Past the last byte.
+ * @param timestamp Timestamp of the latest order already consumed.
+ * @return Returns true if none of the new orders comes before the timestamp.
+ */
+bool order_manifest_orders_after(const char *begin, const char *end, int timestamp) {
+    const char *p = begin;
+
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', (size_t)(end - p));
+        long long value = 0;
+
+        if (line_end == NULL) {
+            line_end = end;
+        }
+        while (p < line_end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+            p++;
+        }
+        if (p < line_end && *p >= '0' && *p <= '9') {
+            while (p < line_end && *p >= '0' && *p <= '9' && value <= INT_MAX) {
+                value = value * 10 + (*p - '0');
+                p++;
+            }
+            if (value < timestamp) {
+                return false;
+            }
+        }
+        p = line_end + 1;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef ORDER_SYSTEM_ORDER_MANIFEST_H
+#define ORDER_SYSTEM_ORDER_MANIFEST_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "order_system.h"
+#define ORDER_MANIFEST_MAGIC "COFMANI"
+#define ORDER_MANIFEST_VERSION 3
+#define ORDER_MANIFEST_HASH_SEED 14695981039346656037ULL
+/** @file */
+
+/**
+ * Sidecar of an append-only orders file, written next to it by an incremental run together with a snapshot of the
+ * simulation backlog (see snapshot_write) and the history of the orders consumed (see order_manifest_write_history).
+ * It tells how much of the orders file has been consumed, so that the next run only reads what was appended since,
+ * and lets it check that the consumed part was not changed by comparing its hash. The header is
+ * followed by the number of orders of each model placed by each customer, customer_count rows of model_count int32.
+ */
+struct OrderManifest {
+    char magic[8]; /**< ORDER_MANIFEST_MAGIC, null terminated. */
+    uint32_t version; /**< ORDER_MANIFEST_VERSION. */
+    uint32_t policy; /**< Scheduling policy of the run, an enum SchedulePolicy. */
+    uint64_t orders_offset; /**< Bytes of the orders file consumed, always just after a new line. */
+    uint64_t prefix_hash; /**< order_manifest_hash of the bytes consumed, carried forward over the new bytes. */
+    uint64_t info_hash; /**< order_manifest_hash of info.dat. */
+    int64_t lines; /**< Number of lines consumed, so that messages about new lines give their line in the file. */
+    int32_t first_timestamp; /**< Timestamp of the first order consumed, hour 1 of the simulation, -1 without orders. */
+    int32_t last_timestamp; /**< Timestamp of the latest order consumed, -1 without orders. */
+    int32_t order_count; /**< Number of orders consumed, the records of the history file and the total orders of the snapshot. */
+    int32_t padding; /**< Unused, zero. */
+    int32_t customer_count; /**< Number of rows of the items sold table. */
+    int32_t model_count; /**< Number of columns of the items sold table. */
+};
+
+uint64_t order_manifest_hash(const char *, size_t, uint64_t);
+bool order_manifest_prefix_matches(const char *, size_t, struct OrderManifest *);
+int order_manifest_hash_file(char *, uint64_t *);
+int order_manifest_read(char *, struct OrderManifest *, int32_t **);
+int order_manifest_write(char *, struct OrderManifest *, const int32_t *);
+int order_manifest_write_history(char *, const struct Order *, int, int);
+bool order_manifest_history_holds(char *, int);
+const struct Order *order_manifest_map_history(char *, int);
+void order_manifest_unmap_history(const struct Order *, int);
+const char *order_manifest_map_orders(char *, size_t *);
+void order_manifest_unmap_orders(const char *, size_t);
+bool order_manifest_orders_after(const char *, const char *, int);
+
+#endif //ORDER_SYSTEM_ORDER_MANIFEST_H
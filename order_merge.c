@@ -0,0 +1,305 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "order_merge.h"
+#include "order_sort.h"
+
+/**
+ * Checks that the timestamps of the file never decrease, reading only the number at the start of each line. Lines
+ * which do not start with a number are left to the reader, which reports the malformed ones. The file is rewound.
+ * @param fptr Pointer to the orders file.
+ * @return Returns true if the file is sorted by timestamp.
+ */
+bool order_stream_is_sorted(FILE *fptr) {
+    char *buffer = malloc(ORDER_READER_BUFFER_SIZE);
+    size_t i, length;
+    int state = 0, value = 0, previous = INT_MIN;
+    bool sorted = true;
+
+    if (buffer == NULL) {
+        printf("Error! not enough memory for the order reader\n");
+        exit(0);
+    }
+    /* state 0: blanks at the start of a line, 1: digits of the timestamp, 2: rest of the line. */
+    while (sorted && (length = fread(buffer, 1, ORDER_READER_BUFFER_SIZE, fptr)) > 0) {
+        for (i = 0; i < length; ++i) {
+            char c = buffer[i];
+
+            if (state == 1 && c >= '0' && c <= '9') {
+                if (value > (INT_MAX - (c - '0')) / 10) {
+                    state = 2;
+                } else {
+                    value = value * 10 + (c - '0');
+                }
+                continue;
+            }
+            if (state == 1) {
+                if (value < previous) {
+                    sorted = false;
+                    break;
+                }
+                previous = value;
+                state = 2;
+            }
+            if (c == '\n') {
+                state = 0;
+            } else if (state == 0 && c >= '0' && c <= '9') {
+                state = 1;
+                value = c - '0';
+            } else if (state == 0 && c != ' ' && c != '\t' && c != '\r') {
+                state = 2;
+            }
+        }
+    }
+    if (sorted && state == 1 && value < previous) {
+        sorted = false;
+    }
+    free(buffer);
+    rewind(fptr);
+    return sorted;
+}
+
+/**
+ * Appends an order to the orders array of the file.
+ */
+static void stream_append(struct OrderStream *stream, struct Order *order) {
+    if (stream->count == stream->capacity) {
+        stream->capacity = stream->capacity > 0 ? stream->capacity * 2 : 64;
+        stream->orders = realloc(stream->orders, stream->capacity * sizeof(struct Order));
+        if (stream->orders == NULL) {
+            printf("Error! not enough memory for %d orders\n", stream->capacity);
+            exit(0);
+        }
+    }
+    stream->orders[stream->count++] = *order;
+}
+
+/**
+ * Gives the priority of an order among the orders of the same timestamp, smaller first: the largest quantity and
+ * then the highest model margin, as in sort_by_priority.
+ */
+static uint64_t priority_key(struct OrderMerge *merge, const struct Order *order) {
+    int model_count = merge->catalog->count;
+    int rank = order->model_id >= 0 && order->model_id < model_count ? merge->ranks[order->model_id] : model_count;
+
+    return ((uint64_t)(INT_MAX - order->quantity) << 32) | (uint32_t)rank;
+}
+
+/**
+ * Puts the orders of one timestamp in priority order, keeping the file order for equal priorities. Small groups,
+ * by far the most common, are insertion sorted; larger ones go through the radix sort of sort_by_priority.
+ */
+static void sort_group(struct OrderMerge *merge, struct Order *orders, int count) {
+    int i, j;
+
+    if (count > ORDER_MERGE_INSERTION_SORT) {
+        sort_by_priority(orders, merge->catalog, count);
+        return;
+    }
+    for (i = 1; i < count; ++i) {
+        struct Order order = orders[i];
+        uint64_t key = priority_key(merge, &order);
+
+        for (j = i; j > 0 && priority_key(merge, &orders[j - 1]) > key; --j) {
+            orders[j] = orders[j - 1];
+        }
+        orders[j] = order;
+    }
+}
+
+/**
+ * Reads the next group of orders with the same timestamp from a sorted file.
+ */
+static void read_group(struct OrderMerge *merge, struct OrderStream *stream) {
+    int timestamp = stream->next.timestamp;
+
+    stream->count = 0;
+    stream->position = 0;
+    if (!stream->has_next) {
+        return;
+    }
+    do {
+        stream_append(stream, &stream->next);
+        stream->has_next = order_reader_next(&stream->reader, &stream->next) == 1;
+    } while (stream->has_next && stream->next.timestamp == timestamp);
+    sort_group(merge, stream->orders, stream->count);
+}
+
+/**
+ * Compares the next orders of two files.
+ * @return Returns true if the file a comes before the file b.
+ */
+static bool stream_before(struct OrderMerge *merge, int a, int b) {
+    const struct Order *x = &merge->streams[a].orders[merge->streams[a].position];
+    const struct Order *y = &merge->streams[b].orders[merge->streams[b].position];
+    uint64_t x_key, y_key;
+
+    if (x->timestamp != y->timestamp) {
+        return x->timestamp < y->timestamp;
+    }
+    x_key = priority_key(merge, x);
+    y_key = priority_key(merge, y);
+    if (x_key != y_key) {
+        return x_key < y_key;
+    }
+    return a < b;
+}
+
+/**
+ * Moves the file at the given heap position down to its place.
+ */
+static void sift_down(struct OrderMerge *merge, int position) {
+    int stream = merge->heap[position];
+
+    for (;;) {
+        int child = 2 * position + 1;
+
+        if (child >= merge->heap_size) {
+            break;
+        }
+        if (child + 1 < merge->heap_size && stream_before(merge, merge->heap[child + 1], merge->heap[child])) {
+            child++;
+        }
+        if (!stream_before(merge, merge->heap[child], stream)) {
+            break;
+        }
+        merge->heap[position] = merge->heap[child];
+        position = child;
+    }
+    merge->heap[position] = stream;
+}
+
+/**
+ * Opens the orders files and reads the first group of each. Every file is checked first: a file sorted by timestamp
+ * is then read lazily, an unsorted one is read whole and sorted by priority, with a message.
+ * @param merge Pointer reference to the OrderMerge struct.
+ * @param names Names of the orders files, in the order used for orders with the same timestamp and priority.
+ * @param count Number of files.
+ * @param catalog Pointer reference to the ModelCatalog struct which gives each model name its id.
+ * @param customers Pointer reference to the InternTable which gives the customers their ids in the merge.
+ */
+void order_merge_open(struct OrderMerge *merge, char **names, int count, struct ModelCatalog *catalog, struct InternTable *customers) {
+    int i;
+
+    merge->streams = calloc(count > 0 ? count : 1, sizeof(struct OrderStream));
+    merge->heap = malloc((count > 0 ? count : 1) * sizeof(int));
+    merge->ranks = malloc((catalog->count > 0 ? catalog->count : 1) * sizeof(int));
+    merge->stream_count = count;
+    merge->heap_size = 0;
+    merge->catalog = catalog;
+    merge->customers = customers;
+    if (merge->streams == NULL || merge->heap == NULL || merge->ranks == NULL) {
+        printf("Error! not enough memory to merge %d files\n", count);
+        exit(0);
+    }
+    model_margin_ranks(catalog->models, catalog->count, merge->ranks);
+
+    for (i = 0; i < count; ++i) {
+        struct OrderStream *stream = &merge->streams[i];
+
+        stream->name = names[i];
+        read_file(&stream->fptr, names[i]);
+        intern_table_init(&stream->customers);
+        order_reader_init(&stream->reader, stream->fptr, &catalog->names, &stream->customers);
+        stream->reader.name = names[i];
+        if (order_stream_is_sorted(stream->fptr)) {
+            stream->has_next = order_reader_next(&stream->reader, &stream->next) == 1;
+            read_group(merge, stream);
+        } else {
+            printf("File %s is not sorted by timestamp, sorting it in memory\n", names[i]);
+            while (order_reader_next(&stream->reader, &stream->next)) {
+                stream_append(stream, &stream->next);
+            }
+            sort_by_priority(stream->orders, catalog, stream->count);
+            order_reader_free(&stream->reader);
+            fclose(stream->fptr);
+            stream->fptr = NULL;
+        }
+        if (stream->count > 0) {
+            merge->heap[merge->heap_size++] = i;
+        }
+    }
+    for (i = merge->heap_size / 2 - 1; i >= 0; --i) {
+        sift_down(merge, i);
+    }
+}
+
+/**
+ * Gives the id in the merge of a customer of a file, adding the customer on its first order.
+ */
+static int merged_customer(struct OrderMerge *merge, struct OrderStream *stream, int customer_id) {
+    if (customer_id >= stream->customer_map_size) {
+        int i, size = stream->customer_map_size > 0 ? stream->customer_map_size : 64;
+
+        while (size <= customer_id) {
+            size *= 2;
+        }
+        stream->customer_map = realloc(stream->customer_map, size * sizeof(int));
+        if (stream->customer_map == NULL) {
+            printf("Error! not enough memory for %d customers\n", size);
+            exit(0);
+        }
+        for (i = stream->customer_map_size; i < size; ++i) {
+            stream->customer_map[i] = -1;
+        }
+        stream->customer_map_size = size;
+    }
+    if (stream->customer_map[customer_id] < 0) {
+        const char *name = intern_table_name(&stream->customers, customer_id);
+
+        stream->customer_map[customer_id] = intern_table_id(merge->customers, name, strlen(name));
+    }
+    return stream->customer_map[customer_id];
+}
+
+/**
+ * Gives the next order of the merge.
+ * @param merge Pointer reference to the OrderMerge struct.
+ * @param order Pointer reference to the Order struct to fill.
+ * @return Returns 1 if an order was given, 0 once every file is exhausted.
+ */
+int order_merge_next(struct OrderMerge *merge, struct Order *order) {
+    struct OrderStream *stream;
+
+    if (merge->heap_size == 0) {
+        return 0;
+    }
+    stream = &merge->streams[merge->heap[0]];
+    *order = stream->orders[stream->position++];
+    order->customer_id = merged_customer(merge, stream, order->customer_id);
+    if (stream->position == stream->count) {
+        if (stream->fptr != NULL) {
+            read_group(merge, stream);
+        }
+        if (stream->position == stream->count) {
+            merge->heap[0] = merge->heap[--merge->heap_size];
+        }
+    }
+    if (merge->heap_size > 0) {
+        sift_down(merge, 0);
+    }
+    return 1;
+}
+
+/**
+ * Closes the files and releases the memory of the merge.
+ * @param merge Pointer reference to the OrderMerge struct.
+ */
+void order_merge_close(struct OrderMerge *merge) {
+    int i;
+
+    for (i = 0; i < merge->stream_count; ++i) {
+        order_reader_free(&merge->streams[i].reader);
+        intern_table_free(&merge->streams[i].customers);
+        free(merge->streams[i].customer_map);
+        if (merge->streams[i].fptr != NULL) {
+            fclose(merge->streams[i].fptr);
+        }
+        free(merge->streams[i].orders);
+    }
+    free(merge->streams);
+    free(merge->heap);
+    free(merge->ranks);
+}
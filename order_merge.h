@@ -0,0 +1,52 @@
+#ifndef ORDER_SYSTEM_ORDER_MERGE_H
+#define ORDER_SYSTEM_ORDER_MERGE_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "order_system.h"
+#include "order_reader.h"
+#define ORDER_MERGE_INSERTION_SORT 32
+/** @file */
+
+/**
+ * One orders file of a merge. A file sorted by timestamp is read lazily, one group of orders with the same timestamp
+ * at a time, and the group is put in priority order; an unsorted file is read whole and sorted by priority.
+ * Either way the orders array holds the orders still to be merged, from position to count.
+ */
+struct OrderStream {
+    char *name; /**< Name of the file. */
+    FILE *fptr; /**< File the orders are read from, NULL once the file is read whole. */
+    struct OrderReader reader; /**< Reader of the file. */
+    struct InternTable customers; /**< Customer names of the file, the customer ids of its orders. */
+    int *customer_map; /**< Customer id in the merge of each customer of the file, -1 until its first order comes out. */
+    int customer_map_size; /**< Allocated length of the customer_map array. */
+    struct Order *orders; /**< Current group of orders, or every order of an unsorted file. */
+    int count; /**< Number of orders in the orders array. */
+    int capacity; /**< Allocated length of the orders array. */
+    int position; /**< Next order to merge in the orders array. */
+    struct Order next; /**< First order of the next group, read ahead to find the end of the current group. */
+    bool has_next; /**< Set while the next field holds an order. */
+};
+
+/**
+ * Lazy k-way merge of orders files. A binary min-heap holds the files by their next order, compared by timestamp,
+ * then by priority (largest quantity first, then highest model margin first) and then by file position on the command
+ * line, so the orders come out in the order sort_by_priority gives to the files read one after the other. Memory
+ * is bounded by one timestamp group per sorted file.
+ */
+struct OrderMerge {
+    struct OrderStream *streams; /**< Files merged, in command line order. */
+    int stream_count; /**< Number of files. */
+    int *heap; /**< Index of the files with orders left, heap ordered by their next order. */
+    int heap_size; /**< Number of files in the heap. */
+    int *ranks; /**< Margin rank of each model, see model_margin_ranks. */
+    struct ModelCatalog *catalog; /**< Item models. */
+    struct InternTable *customers; /**< Customer names of the merge, numbered in the order the orders come out. */
+};
+
+bool order_stream_is_sorted(FILE *);
+void order_merge_open(struct OrderMerge *, char **, int, struct ModelCatalog *, struct InternTable *);
+int order_merge_next(struct OrderMerge *, struct Order *);
+void order_merge_close(struct OrderMerge *);
+
+#endif //ORDER_SYSTEM_ORDER_MERGE_H
@@ -0,0 +1,346 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "order_reader.h"
+
+/**
+ * Prepares the reader for reading orders from the given file.
+ * @param reader Pointer reference to the OrderReader struct.
+ * @param fptr Pointer to the orders file.
+ * @param model_names Model names of the catalog, the id of a name is its model id.
+ * @param customers Customer names, receiving the customers of the orders read.
+ */
+void order_reader_init(struct OrderReader *reader, FILE *fptr, struct InternTable *model_names, struct InternTable *customers) {
+    reader->fptr = fptr;
+    reader->model_names = model_names;
+    reader->customers = customers;
+    reader->buffer = malloc(ORDER_READER_BUFFER_SIZE);
+    reader->length = 0;
+    reader->position = 0;
+    reader->line = 0;
+    reader->eof = 0;
+    reader->name = NULL;
+
+    if (reader->buffer == NULL) {
+        printf("Error! not enough memory for the order reader\n");
+        exit(0);
+    }
+}
+
+/**
+ * Releases the read buffer. The file itself is left open.
+ * @param reader Pointer reference to the OrderReader struct.
+ */
+void order_reader_free(struct OrderReader *reader) {
+    free(reader->buffer);
+    reader->buffer = NULL;
+}
+
+/**
+ * Skips blanks (spaces, tabs and carriage returns) inside a line.
+ */
+static const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * Parses a non negative decimal integer, rejecting values which do not fit in an int.
+ * @return Returns pointer past the last digit, or NULL if no valid number was found.
+ */
+static const char *parse_int(const char *p, const char *end, int *value) {
+    int result = 0;
+    const char *start = p;
+
+    while (p < end && *p >= '0' && *p <= '9') {
+        int digit = *p - '0';
+        if (result > (INT_MAX - digit) / 10) {
+            return NULL;
+        }
+        result = result * 10 + digit;
+        p++;
+    }
+    if (p == start) {
+        return NULL;
+    }
+    *value = result;
+    return p;
+}
+
+/**
+ * Parses one line of the orders file in the form "timestamp model quantity customer".
+ * The model name is resolved to its id once here; a name missing from the catalog gives the id -1.
+ * The customer name, shorter than CUSTOMER_NAME_LENGTH, is interned only once the whole line is valid.
+ * @param begin Pointer to the first character of the line.
+ * @param end Pointer past the last character of the line (newline excluded).
+ * @param model_names Model names of the catalog.
+ * @param customers Customer names, which give the customer id of the order.
+ * @param order Pointer reference to the Order struct to fill.
+ * @return Returns 1 if an order was parsed, 0 for an empty line and -1 for a malformed line.
+ */
+int parse_order_line(const char *begin, const char *end, struct InternTable *model_names, struct InternTable *customers, struct Order *order) {
+    const char *p = skip_blanks(begin, end);
+    const char *name;
+    size_t name_length;
+
+    if (p == end) {
+        return 0;
+    }
+
+    p = parse_int(p, end, &order->timestamp);
+    if (p == NULL || p == end || (*p != ' ' && *p != '\t')) {
+        return -1;
+    }
+
+    name = skip_blanks(p, end);
+    p = name;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r') {
+        p++;
+    }
+    name_length = (size_t)(p - name);
+    if (name_length == 0 || name_length >= MODEL_NAME_LENGTH || p == end) {
+        return -1;
+    }
+    order->model_id = intern_table_find(model_names, name, name_length);
+
+    p = skip_blanks(p, end);
+    p = parse_int(p, end, &order->quantity);
+    if (p == NULL || p == end || (*p != ' ' && *p != '\t')) {
+        return -1;
+    }
+
+    name = skip_blanks(p, end);
+    p = name;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r') {
+        p++;
+    }
+    name_length = (size_t)(p - name);
+    if (name_length == 0 || name_length >= CUSTOMER_NAME_LENGTH || skip_blanks(p, end) != end) {
+        return -1;
+    }
+    order->customer_id = intern_table_id(customers, name, name_length);
+    return 1;
+}
+
+/**
+ * Moves the unread bytes to the start of the buffer and fills the rest from the file.
+ * @return Returns the number of new bytes read.
+ */
+static size_t refill(struct OrderReader *reader) {
+    size_t remaining = reader->length - reader->position;
+    size_t read;
+
+    if (reader->eof || (reader->position == 0 && remaining == ORDER_READER_BUFFER_SIZE)) {
+        return 0;
+    }
+    memmove(reader->buffer, reader->buffer + reader->position, remaining);
+    reader->position = 0;
+    reader->length = remaining;
+
+    read = fread(reader->buffer + remaining, 1, ORDER_READER_BUFFER_SIZE - remaining, reader->fptr);
+    if (read == 0) {
+        reader->eof = 1;
+    }
+    reader->length += read;
+    return read;
+}
+
+/**
+ * Reports the malformed line just read.
+ */
+static void report_malformed(struct OrderReader *reader) {
+    if (reader->name != NULL) {
+        printf("Malformed order on line %ld of %s, skipping\n", reader->line, reader->name);
+    } else {
+        printf("Malformed order on line %ld, skipping\n", reader->line);
+    }
+}
+
+/**
+ * Reads the next order from the file. Empty lines are skipped, malformed lines are reported and skipped.
+ * @param reader Pointer reference to the OrderReader struct.
+ * @param order Pointer reference to the Order struct to fill.
+ * @return Returns 1 if an order was read, 0 at the end of the file.
+ */
+int order_reader_next(struct OrderReader *reader, struct Order *order) {
+    for (;;) {
+        char *begin = reader->buffer + reader->position;
+        char *end = memchr(begin, '\n', reader->length - reader->position);
+        int result;
+
+        if (end == NULL) {
+            if (refill(reader) > 0) {
+                continue;
+            }
+            if (reader->position == reader->length) {
+                return 0;
+            }
+            if (reader->length == ORDER_READER_BUFFER_SIZE) {
+                /* A line that does not fit in the buffer can not be a valid order, drop it up to its newline. */
+                reader->line++;
+                report_malformed(reader);
+                do {
+                    reader->position = reader->length;
+                    refill(reader);
+                    end = memchr(reader->buffer, '\n', reader->length);
+                } while (end == NULL && !reader->eof);
+                reader->position = end == NULL ? reader->length : (size_t)(end - reader->buffer) + 1;
+                continue;
+            }
+            /* Last line of the file without a trailing newline. */
+            begin = reader->buffer + reader->position;
+            end = reader->buffer + reader->length;
+            reader->position = reader->length;
+        } else {
+            reader->position = (size_t)(end - reader->buffer) + 1;
+        }
+
+        reader->line++;
+        result = parse_order_line(begin, end, reader->model_names, reader->customers, order);
+        if (result == 1) {
+            return 1;
+        }
+        if (result < 0) {
+            report_malformed(reader);
+        }
+    }
+}
+
+/**
+ * Reads up to max_orders orders, so that callers can process the file in batches of constant size.
+ * @param reader Pointer reference to the OrderReader struct.
+ * @param orders Pointer to the array receiving the orders.
+ * @param max_orders Size of the orders array.
+ * @return Returns the number of orders read, 0 at the end of the file.
+ */
+int order_reader_read_batch(struct OrderReader *reader, struct Order *orders, int max_orders) {
+    int i = 0;
+
+    while (i < max_orders && order_reader_next(reader, &orders[i])) {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * Appends an item to a growable array, doubling its capacity as needed.
+ */
+static void *grow_array(void *array, int count, int *capacity, size_t item_size) {
+    if (count < *capacity) {
+        return array;
+    }
+    *capacity = *capacity > 0 ? *capacity * 2 : 1024;
+    array = realloc(array, *capacity * item_size);
+    if (array == NULL) {
+        printf("Error! not enough memory for %d lines\n", *capacity);
+        exit(0);
+    }
+    return array;
+}
+
+/**
+ * Parses every line of a chunk, with the same rules as order_reader_next: empty lines are skipped and malformed lines,
+ * including lines too long for the reader buffer, are recorded instead of being printed so that the caller can report
+ * them in file order. Only the chunk itself is written, so chunks can be parsed in parallel.
+ * @param chunk Pointer reference to the OrderChunk struct, with begin and end set.
+ * @param model_names Model names of the catalog, only read.
+ * @param model_count Number of models of the catalog.
+ */
+void order_chunk_parse(struct OrderChunk *chunk, struct InternTable *model_names, int model_count) {
+    const char *p = chunk->begin;
+
+    chunk->orders = NULL;
+    chunk->count = 0;
+    chunk->capacity = 0;
+    chunk->lines = 0;
+    chunk->malformed = NULL;
+    chunk->malformed_count = 0;
+    chunk->malformed_capacity = 0;
+    chunk->model_orders = calloc(model_count > 0 ? model_count : 1, sizeof(int));
+    if (chunk->model_orders == NULL) {
+        printf("Error! not enough memory for %d models\n", model_count);
+        exit(0);
+    }
+    intern_table_init(&chunk->customers);
+
+    while (p < chunk->end) {
+        const char *end = memchr(p, '\n', (size_t)(chunk->end - p));
+        struct Order *order;
+        int result = -1;
+
+        if (end == NULL) {
+            end = chunk->end;
+        }
+        chunk->lines++;
+        chunk->orders = grow_array(chunk->orders, chunk->count, &chunk->capacity, sizeof(struct Order));
+        order = &chunk->orders[chunk->count];
+        if (end - p < ORDER_READER_BUFFER_SIZE) {
+            result = parse_order_line(p, end, model_names, &chunk->customers, order);
+        }
+        if (result == 1) {
+            if (order->model_id >= 0 && order->model_id < model_count) {
+                chunk->model_orders[order->model_id]++;
+            }
+            chunk->count++;
+        } else if (result < 0) {
+            chunk->malformed = grow_array(chunk->malformed, chunk->malformed_count, &chunk->malformed_capacity, sizeof(long));
+            chunk->malformed[chunk->malformed_count++] = chunk->lines;
+        }
+        p = end + 1;
+    }
+}
+
+/**
+ * Parses the lines of a part of an orders file held in memory, with the rules of order_reader_next: empty lines are
+ * skipped and malformed lines, including lines too long for the reader buffer, are reported and skipped.
+ * @param begin First byte, at the start of a line.
+ * @param end Past the last byte, just after a new line.
+ * @param line Number of the lines before begin, updated to the number of the last line parsed.
+ * @param model_names Model names of the catalog.
+ * @param customers Customer names, which give the customer id of each order.
+ * @param orders Pointer to the array of Order structs, allocated by this function.
+ * @return Returns the number of orders parsed.
+ */
+int order_reader_parse_lines(const char *begin, const char *end, long *line, struct InternTable *model_names, struct InternTable *customers, struct Order **orders) {
+    const char *p = begin;
+    struct Order *list = NULL;
+    int count = 0, capacity = 0;
+
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', (size_t)(end - p));
+        int result = -1;
+
+        if (line_end == NULL) {
+            line_end = end;
+        }
+        (*line)++;
+        list = grow_array(list, count, &capacity, sizeof(struct Order));
+        if (line_end - p < ORDER_READER_BUFFER_SIZE) {
+            result = parse_order_line(p, line_end, model_names, customers, &list[count]);
+        }
+        if (result == 1) {
+            count++;
+        } else if (result < 0) {
+            printf("Malformed order on line %ld, skipping\n", *line);
+        }
+        p = line_end + 1;
+    }
+    *orders = list;
+    return count;
+}
+
+/**
+ * Releases what a chunk allocated while parsing.
+ * @param chunk Pointer reference to the OrderChunk struct.
+ */
+void order_chunk_free(struct OrderChunk *chunk) {
+    free(chunk->orders);
+    free(chunk->model_orders);
+    free(chunk->malformed);
+    intern_table_free(&chunk->customers);
+    chunk->orders = NULL;
+}
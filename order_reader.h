@@ -0,0 +1,54 @@
+#ifndef ORDER_SYSTEM_ORDER_READER_H
+#define ORDER_SYSTEM_ORDER_READER_H
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "order_system.h"
+#define ORDER_READER_BUFFER_SIZE (1 << 16)
+#define ORDER_READER_CHUNK_SIZE (1 << 22)
+/** @file */
+
+/**
+ * Streaming reader for order files. Reads the file in fixed size chunks and tokenizes one line at a time,
+ * so the memory used for reading stays constant whatever the size of the file.
+ */
+struct OrderReader {
+    FILE *fptr; /**< File the orders are read from. */
+    char *buffer; /**< Read buffer of ORDER_READER_BUFFER_SIZE bytes. */
+    size_t length; /**< Number of valid bytes in the buffer. */
+    size_t position; /**< Offset of the next unread byte in the buffer. */
+    long line; /**< Number of the last line read, used in error messages. */
+    int eof; /**< Set once the underlying file has no more data. */
+    struct InternTable *model_names; /**< Model names of the catalog, which give the model id of each order. */
+    struct InternTable *customers; /**< Customer names, which give the customer id of each order. */
+    const char *name; /**< File name added to the messages when several files are read together, NULL to omit it. */
+};
+
+/**
+ * Newline aligned slice of an orders file parsed on its own thread. Customers get ids local to the chunk, in order
+ * of first appearance in the chunk, which are mapped to the global ids when the chunks are merged in file order.
+ */
+struct OrderChunk {
+    const char *begin; /**< First byte of the chunk, at the start of a line. */
+    const char *end; /**< Past the last byte of the chunk, just after a newline or at the end of the file. */
+    struct Order *orders; /**< Orders parsed, with customer ids local to the chunk. */
+    int count; /**< Number of orders parsed. */
+    int capacity; /**< Allocated length of the orders array. */
+    int *model_orders; /**< Number of orders of each model in the chunk. */
+    struct InternTable customers; /**< Customer names of the chunk, the local customer ids. */
+    long lines; /**< Number of lines of the chunk. */
+    long *malformed; /**< Line numbers, counted from the start of the chunk, of the malformed lines. */
+    int malformed_count; /**< Number of malformed lines. */
+    int malformed_capacity; /**< Allocated length of the malformed array. */
+};
+
+void order_chunk_parse(struct OrderChunk *, struct InternTable *, int);
+void order_chunk_free(struct OrderChunk *);
+void order_reader_init(struct OrderReader *, FILE *, struct InternTable *, struct InternTable *);
+void order_reader_free(struct OrderReader *);
+int order_reader_next(struct OrderReader *, struct Order *);
+int order_reader_read_batch(struct OrderReader *, struct Order *, int);
+int order_reader_parse_lines(const char *, const char *, long *, struct InternTable *, struct InternTable *, struct Order **);
+int parse_order_line(const char *, const char *, struct InternTable *, struct InternTable *, struct Order *);
+
+#endif //ORDER_SYSTEM_ORDER_READER_H
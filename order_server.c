@@ -0,0 +1,557 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "order_server.h"
+#include "order_reader.h"
+#include "stock.h"
+#include "snapshot.h"
+
+/**
+ * Set by SIGINT and SIGTERM to stop serving.
+ */
+static volatile sig_atomic_t interrupted = 0;
+
+/**
+ * Input and pending replies of one client.
+ */
+struct ServerConnection {
+    int in_fd; /**< Descriptor the commands are read from. */
+    int out_fd; /**< Descriptor the replies are written to. */
+    char *input; /**< Bytes read and not processed yet, ORDER_SERVER_BUFFER_SIZE bytes. */
+    size_t input_length; /**< Number of bytes in input. */
+    bool discarding; /**< Set while skipping the rest of a line longer than the buffer. */
+    char *output; /**< Replies not written yet. */
+    size_t output_length; /**< Number of bytes in output. */
+    size_t output_capacity; /**< Allocated size of output. */
+};
+
+/**
+ * Signal handler of SIGINT and SIGTERM.
+ */
+static void on_interrupt(int signal_number) {
+    (void)signal_number;
+    interrupted = 1;
+}
+
+/**
+ * Starts the server from the orders already loaded. The orders are fed to the simulation in their current order
+ * (sort them by priority first to match a batch run) and queue up at the starting hour, as in a batch run.
+ * @param server Pointer reference to the OrderServer struct.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param stats Pointer reference to the ModelOrderingStats struct, already counting the loaded orders.
+ * @param customers Pointer reference to the InternTable of the customer names.
+ * @param aggregates Pointer reference to the DailyAggregates struct, already holding the loaded orders.
+ * @param orders Array of the loaded orders allocated with malloc, owned by the server from now on.
+ * @param orders_count Number of loaded orders.
+ * @param metrics Pointer reference to the SimulationMetrics struct to fill, NULL to skip the metrics.
+ * @param events Pointer reference to the EventLog receiving the events, NULL to skip the journal.
+ * @param policy Order in which waiting orders get the workers; a restored snapshot brings its own.
+ */
+void order_server_init(struct OrderServer *server, struct SystemInfo *system, struct ModelCatalog *catalog, struct ModelOrderingStats *stats, struct InternTable *customers, struct DailyAggregates *aggregates, struct Order *orders, int orders_count, struct SimulationMetrics *metrics, struct EventLog *events, enum SchedulePolicy policy) {
+    int i;
+
+    server->system = system;
+    server->catalog = catalog;
+    server->stats = stats;
+    server->customers = customers;
+    server->aggregates = aggregates;
+    server->orders = orders;
+    server->orders_count = orders_count;
+    server->orders_capacity = 0;
+    server->from_stock = NULL;
+    order_server_reserve(server, orders_count);
+    server->stopping = false;
+    server->snapshot_file_name = NULL;
+    memset(&server->result, 0, sizeof(server->result));
+
+    stock_init(&server->stock, system->storage_capacity, catalog->models, catalog->count);
+    scheduler_init(&server->scheduler, 1, NULL);
+    server->scheduler.catalog = catalog;
+    server->scheduler.customers = customers;
+    server->scheduler.metrics = metrics;
+    server->scheduler.event_log = events;
+    server->scheduler.policy = policy;
+    for (i = 0; i < orders_count; ++i) {
+        int from_stock = server->result.orders_from_stock;
+
+        simulate_order(server->orders, i, stats, system, &server->stock, catalog, &server->scheduler, &server->result);
+        if (server->result.orders_from_stock > from_stock) {
+            server->from_stock[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+}
+
+/**
+ * Releases the orders, the stock, the scheduler and the idle ranges of the server.
+ * @param server Pointer reference to the OrderServer struct.
+ */
+void order_server_free(struct OrderServer *server) {
+    free(server->orders);
+    free(server->from_stock);
+    stock_free(&server->stock);
+    scheduler_free(&server->scheduler);
+    simulation_result_free(&server->result);
+    server->orders = NULL;
+    server->from_stock = NULL;
+}
+
+/**
+ * Makes room for the given number of orders in the orders array and the bits of the orders served from stock.
+ * @param server Pointer reference to the OrderServer struct.
+ * @param capacity Number of orders to make room for.
+ */
+void order_server_reserve(struct OrderServer *server, int capacity) {
+    size_t words = ((size_t)capacity + 63) / 64, old_words = ((size_t)server->orders_capacity + 63) / 64;
+
+    if (capacity <= server->orders_capacity) {
+        return;
+    }
+    server->orders = realloc(server->orders, (size_t)capacity * sizeof(struct Order));
+    server->from_stock = realloc(server->from_stock, words * sizeof(uint64_t));
+    if (server->orders == NULL || server->from_stock == NULL) {
+        printf("Error! not enough memory for %d orders\n", capacity);
+        exit(0);
+    }
+    memset(server->from_stock + old_words, 0, (words - old_words) * sizeof(uint64_t));
+    server->orders_capacity = capacity;
+}
+
+/**
+ * Adds a new order: it is counted in the daily aggregates and the ordering stats, then served from stock or queued.
+ * An order the daily aggregates can not hold is rejected before anything changes.
+ * @param server Pointer reference to the OrderServer struct.
+ * @param order Pointer reference to the parsed order, with its customer id in the customers of the server.
+ * @return Returns what happened to the order, whose id is orders_count - 1 unless it was rejected.
+ */
+enum ServerOrderStatus order_server_add(struct OrderServer *server, struct Order *order) {
+    int from_stock = server->result.orders_from_stock, blocked = server->result.blocked_orders, id;
+
+    if (daily_aggregates_add(server->aggregates, order->timestamp, order->model_id, order->quantity) != 0) {
+        return SERVER_ORDER_REJECTED;
+    }
+    if (server->orders_count == server->orders_capacity) {
+        order_server_reserve(server, server->orders_capacity > 0 ? server->orders_capacity * 2 : 1024);
+    }
+    server->orders[server->orders_count] = *order;
+
+    update_ordering_stats(order->model_id, server->stats);
+    server->stats->total_orders++;
+    simulate_order(server->orders, server->orders_count++, server->stats, server->system, &server->stock, server->catalog, &server->scheduler, &server->result);
+
+    if (server->result.orders_from_stock > from_stock) {
+        id = server->orders_count - 1;
+        server->from_stock[id / 64] |= (uint64_t)1 << (id % 64);
+        return SERVER_ORDER_FROM_STOCK;
+    }
+    return server->result.blocked_orders > blocked ? SERVER_ORDER_BLOCKED : SERVER_ORDER_QUEUED;
+}
+
+/**
+ * Cancels an order served from stock: its items go back into the stock, as many as still fit, and it is taken out of
+ * the ordering stats and the daily aggregates. Queued, running and blocked orders can not be cancelled.
+ * @param server Pointer reference to the OrderServer struct.
+ * @param id Id of the order.
+ * @return Returns the number of items put back, -1 if the order was not served from stock or is already cancelled.
+ */
+int order_server_cancel(struct OrderServer *server, int id) {
+    struct Order *order;
+
+    if (id < 0 || id >= server->orders_count || !((server->from_stock[id / 64] >> (id % 64)) & 1) || server->orders[id].model_id < 0) {
+        return -1;
+    }
+    order = &server->orders[id];
+    server->from_stock[id / 64] &= ~((uint64_t)1 << (id % 64));
+    server->result.orders_from_stock--;
+    server->stats->model_orders[order->model_id]--;
+    server->stats->total_orders--;
+    daily_aggregates_add(server->aggregates, order->timestamp, order->model_id, -order->quantity);
+    return stock_release(&server->stock, order->model_id, order->quantity);
+}
+
+/**
+ * Reads an integer argument of a command.
+ * @return Returns the position after the integer, NULL if there is none.
+ */
+static char *integer_argument(char *p, long *value) {
+    char *end;
+
+    *value = strtol(p, &end, 10);
+    return end == p || *value < 0 || *value > 2147483647L ? NULL : end;
+}
+
+/**
+ * Runs one command line and writes its one line reply.
+ * ORDER timestamp model quantity customer (the orders.dat layout) adds an order and replies with its id and
+ * whether it was served from stock, queued or blocked. CANCEL id cancels an order served from stock and puts its items
+ * back (see order_server_cancel). ADVANCE hours moves the clock, starting the queued orders
+ * which fit and completing the running ones. STATS gives the counters of the simulation, REVENUE from to the revenue
+ * and margin of the orders placed between two days and ITEMS model from to the items of one model ordered between
+ * two days, both from the daily aggregates in O(log days). SNAPSHOT [file] saves the whole state (see snapshot_write), to
+ * the snapshot file of the server by default. QUIT closes the connection and SHUTDOWN stops the server.
+ * @param server Pointer reference to the OrderServer struct.
+ * @param line Null terminated command, without the new line.
+ * @param reply Buffer receiving the reply, new line included.
+ * @param reply_size Size of the reply buffer.
+ * @return Returns 1 to keep reading from the connection, 0 to close it.
+ */
+int order_server_execute(struct OrderServer *server, char *line, char *reply, size_t reply_size) {
+    static const char *status_names[] = {"stock", "queued", "blocked"};
+    struct Scheduler *scheduler = &server->scheduler;
+    struct Order order;
+    enum ServerOrderStatus status;
+    long from, to;
+    char *p;
+
+    if (strncmp(line, "ORDER ", 6) == 0) {
+        if (parse_order_line(line + 6, line + strlen(line), &server->catalog->names, server->customers, &order) != 1) {
+            snprintf(reply, reply_size, "ERR malformed order\n");
+            return 1;
+        }
+        status = order_server_add(server, &order);
+        if (status == SERVER_ORDER_REJECTED) {
+            snprintf(reply, reply_size, "ERR day out of range\n");
+            return 1;
+        }
+        snprintf(reply, reply_size, "OK %d %s\n", server->orders_count - 1, status_names[status]);
+        return 1;
+    }
+    if (strncmp(line, "CANCEL ", 7) == 0) {
+        int released;
+
+        if ((p = integer_argument(line + 7, &from)) == NULL || *p != '\0') {
+            snprintf(reply, reply_size, "ERR invalid order\n");
+            return 1;
+        }
+        if ((released = order_server_cancel(server, (int)from)) < 0) {
+            snprintf(reply, reply_size, "ERR order not served from stock\n");
+            return 1;
+        }
+        snprintf(reply, reply_size, "OK %ld released=%d\n", from, released);
+        return 1;
+    }
+    if (strncmp(line, "ADVANCE ", 8) == 0) {
+        if ((p = integer_argument(line + 8, &from)) == NULL || *p != '\0' || from > 2147483647L - scheduler->clock) {
+            snprintf(reply, reply_size, "ERR invalid hours\n");
+            return 1;
+        }
+        scheduler_run(scheduler, server->orders, server->system, scheduler->clock + (int)from);
+        snprintf(reply, reply_size, "OK clock=%d processed=%d waiting=%d running=%d\n",
+                 scheduler->clock, scheduler->processed, scheduler->ready_count, scheduler->events_count);
+        return 1;
+    }
+    if (strcmp(line, "STATS") == 0) {
+        snprintf(reply, reply_size, "OK orders=%d processed=%d from_stock=%d blocked=%d waiting=%d running=%d clock=%d free_workers=%d idle_days=%d stocked_space=%lld\n",
+                 server->orders_count, scheduler->processed, server->result.orders_from_stock, server->result.blocked_orders,
+                 scheduler->ready_count, scheduler->events_count, scheduler->clock, server->system->number_of_workers,
+                 server->result.idle_days, server->stock.occupied_space);
+        return 1;
+    }
+    if (strncmp(line, "REVENUE ", 8) == 0) {
+        double revenue, margin;
+
+        if ((p = integer_argument(line + 8, &from)) == NULL || (p = integer_argument(p, &to)) == NULL || *p != '\0') {
+            snprintf(reply, reply_size, "ERR invalid days\n");
+            return 1;
+        }
+        daily_aggregates_range(server->aggregates, (int)from, (int)to, &revenue, &margin);
+        snprintf(reply, reply_size, "OK revenue=%.2f margin=%.2f\n", revenue, margin);
+        return 1;
+    }
+    if (strncmp(line, "ITEMS ", 6) == 0) {
+        char *name = line + 6;
+        int model_id;
+
+        for (p = name; *p != ' ' && *p != '\0'; ++p) {
+        }
+        model_id = intern_table_find(&server->catalog->names, name, (size_t)(p - name));
+        if (model_id < 0) {
+            snprintf(reply, reply_size, "ERR unknown model\n");
+            return 1;
+        }
+        if ((p = integer_argument(p, &from)) == NULL || (p = integer_argument(p, &to)) == NULL || *p != '\0') {
+            snprintf(reply, reply_size, "ERR invalid days\n");
+            return 1;
+        }
+        snprintf(reply, reply_size, "OK items=%lld\n", daily_aggregates_model_quantity(server->aggregates, model_id, (int)from, (int)to));
+        return 1;
+    }
+    if (strcmp(line, "SNAPSHOT") == 0 || strncmp(line, "SNAPSHOT ", 9) == 0) {
+        char *name = line[8] == ' ' ? line + 9 : server->snapshot_file_name;
+
+        if (name == NULL || *name == '\0') {
+            snprintf(reply, reply_size, "ERR no snapshot file\n");
+        } else if (snapshot_write(name, server, false) != 0) {
+            snprintf(reply, reply_size, "ERR snapshot failed\n");
+        } else {
+            snprintf(reply, reply_size, "OK snapshot orders=%d clock=%d\n", server->orders_count, scheduler->clock);
+        }
+        return 1;
+    }
+    if (strcmp(line, "QUIT") == 0 || strcmp(line, "SHUTDOWN") == 0) {
+        server->stopping = server->stopping || line[0] == 'S';
+        snprintf(reply, reply_size, "BYE\n");
+        return 0;
+    }
+    snprintf(reply, reply_size, "ERR unknown command\n");
+    return 1;
+}
+
+/**
+ * Prepares the buffers of a connection.
+ */
+static void connection_init(struct ServerConnection *connection, int in_fd, int out_fd) {
+    connection->in_fd = in_fd;
+    connection->out_fd = out_fd;
+    connection->input = malloc(ORDER_SERVER_BUFFER_SIZE);
+    connection->input_length = 0;
+    connection->discarding = false;
+    connection->output_capacity = ORDER_SERVER_BUFFER_SIZE;
+    connection->output = malloc(connection->output_capacity);
+    connection->output_length = 0;
+    if (connection->input == NULL || connection->output == NULL) {
+        printf("Error! not enough memory for a connection\n");
+        exit(0);
+    }
+}
+
+/**
+ * Releases the buffers of a connection.
+ */
+static void connection_free(struct ServerConnection *connection) {
+    free(connection->input);
+    free(connection->output);
+}
+
+/**
+ * Appends a reply to the pending output of a connection.
+ */
+static void connection_reply(struct ServerConnection *connection, const char *reply) {
+    size_t length = strlen(reply);
+
+    if (connection->output_length + length > connection->output_capacity) {
+        while (connection->output_length + length > connection->output_capacity) {
+            connection->output_capacity *= 2;
+        }
+        connection->output = realloc(connection->output, connection->output_capacity);
+        if (connection->output == NULL) {
+            printf("Error! not enough memory for a connection\n");
+            exit(0);
+        }
+    }
+    memcpy(connection->output + connection->output_length, reply, length);
+    connection->output_length += length;
+}
+
+/**
+ * Writes the pending output of a connection. On a non-blocking socket whose peer is not reading, the rest of the
+ * output is kept for the next call.
+ * @return Returns 0 on success (even a partial write), -1 if the peer is gone.
+ */
+static int connection_flush(struct ServerConnection *connection) {
+    size_t written = 0;
+
+    while (written < connection->output_length) {
+        ssize_t result = write(connection->out_fd, connection->output + written, connection->output_length - written);
+
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (result <= 0) {
+            return -1;
+        }
+        written += (size_t)result;
+    }
+    connection->output_length -= written;
+    memmove(connection->output, connection->output + written, connection->output_length);
+    return 0;
+}
+
+/**
+ * Reads what the connection has sent and runs every complete command, batching the replies so that a client
+ * pipelining many commands gets them back in one write.
+ * @return Returns 1 to keep the connection open, 0 to close it.
+ */
+static int connection_read(struct OrderServer *server, struct ServerConnection *connection) {
+    char reply[256];
+    char *line, *newline, *end;
+    ssize_t result;
+    int open = 1;
+
+    do {
+        result = read(connection->in_fd, connection->input + connection->input_length, ORDER_SERVER_BUFFER_SIZE - connection->input_length);
+    } while (result < 0 && errno == EINTR && !interrupted);
+    if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 1;
+    }
+    if (result <= 0) {
+        return 0;
+    }
+    connection->input_length += (size_t)result;
+
+    line = connection->input;
+    end = connection->input + connection->input_length;
+    while (open && (newline = memchr(line, '\n', (size_t)(end - line))) != NULL) {
+        if (connection->discarding) {
+            connection->discarding = false;
+        } else {
+            *newline = '\0';
+            if (newline > line && newline[-1] == '\r') {
+                newline[-1] = '\0';
+            }
+            open = order_server_execute(server, line, reply, sizeof(reply));
+            connection_reply(connection, reply);
+        }
+        line = newline + 1;
+    }
+
+    connection->input_length = (size_t)(end - line);
+    memmove(connection->input, line, connection->input_length);
+    if (connection->input_length == ORDER_SERVER_BUFFER_SIZE) {
+        connection->input_length = 0;
+        if (!connection->discarding) {
+            connection_reply(connection, "ERR line too long\n");
+        }
+        connection->discarding = true;
+    }
+    return connection_flush(connection) == 0 ? open : 0;
+}
+
+/**
+ * Installs the handlers which stop the server on SIGINT and SIGTERM, and ignores SIGPIPE so that a client going away
+ * only closes its connection.
+ */
+static void install_signal_handlers(void) {
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_interrupt;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+}
+
+/**
+ * Serves one client reading commands from in_fd and writing replies to out_fd, typically the standard input and
+ * output, until QUIT, SHUTDOWN or the end of the input.
+ * @param server Pointer reference to the OrderServer struct.
+ * @param in_fd Descriptor the commands are read from.
+ * @param out_fd Descriptor the replies are written to.
+ * @return Returns 0 when the client is done.
+ */
+int order_server_serve_stream(struct OrderServer *server, int in_fd, int out_fd) {
+    struct ServerConnection connection;
+
+    install_signal_handlers();
+    connection_init(&connection, in_fd, out_fd);
+    connection_reply(&connection, "READY\n");
+    if (connection_flush(&connection) == 0) {
+        while (!interrupted && connection_read(server, &connection)) {
+        }
+    }
+    connection_free(&connection);
+    return 0;
+}
+
+/**
+ * Listens on a Unix domain socket and serves up to ORDER_SERVER_MAX_CLIENTS clients at once until SHUTDOWN,
+ * SIGINT or SIGTERM. The clients share the same simulation; their commands run one at a time, so the state needs
+ * no locking. The client sockets are non-blocking: a client with replies left to write is not read from until it
+ * takes them, so a client which stops reading only stalls itself. The socket file is removed when the server stops.
+ * @param server Pointer reference to the OrderServer struct.
+ * @param path Path of the socket, replaced if it exists.
+ * @return Returns 0 when the server is stopped, -1 if the socket could not be created.
+ */
+int order_server_serve_socket(struct OrderServer *server, const char *path) {
+    struct sockaddr_un address;
+    struct pollfd polls[ORDER_SERVER_MAX_CLIENTS + 1];
+    struct ServerConnection connections[ORDER_SERVER_MAX_CLIENTS];
+    int i, listen_fd, client_count = 0;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        printf("Error! socket path %s is too long\n", path);
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+    if ((listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 || bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0
+        || listen(listen_fd, ORDER_SERVER_MAX_CLIENTS) != 0) {
+        printf("Error! listening on %s: %s\n", path, strerror(errno));
+        if (listen_fd >= 0) {
+            close(listen_fd);
+        }
+        return -1;
+    }
+    install_signal_handlers();
+    printf("Listening on %s\n", path);
+    fflush(stdout);
+
+    while (!interrupted && !server->stopping) {
+        polls[0].fd = listen_fd;
+        polls[0].events = POLLIN;
+        for (i = 0; i < client_count; ++i) {
+            polls[i + 1].fd = connections[i].in_fd;
+            polls[i + 1].events = connections[i].output_length > 0 ? POLLOUT : POLLIN;
+        }
+        if (poll(polls, client_count + 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (i = client_count - 1; i >= 0 && !server->stopping; --i) {
+            int open = 1;
+
+            if ((polls[i + 1].revents & POLLOUT) != 0) {
+                open = connection_flush(&connections[i]) == 0;
+            } else if (polls[i + 1].revents != 0) {
+                open = connection_read(server, &connections[i]);
+            }
+            if (!open) {
+                close(connections[i].in_fd);
+                connection_free(&connections[i]);
+                connections[i] = connections[--client_count];
+            }
+        }
+        if ((polls[0].revents & POLLIN) != 0 && !server->stopping) {
+            int client_fd = accept(listen_fd, NULL, NULL);
+
+            if (client_fd >= 0 && client_count == ORDER_SERVER_MAX_CLIENTS) {
+                close(client_fd);
+            } else if (client_fd >= 0) {
+                fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL) | O_NONBLOCK);
+                connection_init(&connections[client_count], client_fd, client_fd);
+                connection_reply(&connections[client_count], "READY\n");
+                if (connection_flush(&connections[client_count]) == 0) {
+                    client_count++;
+                } else {
+                    close(client_fd);
+                    connection_free(&connections[client_count]);
+                }
+            }
+        }
+    }
+
+    for (i = 0; i < client_count; ++i) {
+        close(connections[i].in_fd);
+        connection_free(&connections[i]);
+    }
+    close(listen_fd);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,55 @@
+#ifndef ORDER_SYSTEM_ORDER_SERVER_H
+#define ORDER_SYSTEM_ORDER_SERVER_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "order_system.h"
+#include "daily_stats.h"
+#include "scheduler.h"
+#define ORDER_SERVER_BUFFER_SIZE (1 << 16)
+#define ORDER_SERVER_MAX_CLIENTS 64
+/** @file */
+
+/**
+ * Outcome of an order added to a running server.
+ */
+enum ServerOrderStatus {
+    SERVER_ORDER_FROM_STOCK, /**< Served from stock straight away. */
+    SERVER_ORDER_QUEUED, /**< Waiting for workers, it starts on a later ADVANCE. */
+    SERVER_ORDER_BLOCKED, /**< Model missing from the catalog, the order is kept but never processed. */
+    SERVER_ORDER_REJECTED /**< Day too far from the other orders for the daily aggregates, the order is not added. */
+};
+
+/**
+ * Long running simulation which accepts new orders and queries one line at a time. The stock, the scheduler with
+ * its waiting and running orders and the daily aggregates stay in memory, so each new order costs one step of the
+ * simulation instead of a reload of the whole history. The clock only moves on ADVANCE.
+ */
+struct OrderServer {
+    struct SystemInfo *system; /**< System information, its free workers change as orders start and complete. */
+    struct ModelCatalog *catalog; /**< Item models. */
+    struct ModelOrderingStats *stats; /**< Orders per model, which drive the stock prepared on idle days. */
+    struct InternTable *customers; /**< Customer names, which give the customer id of each order. */
+    struct DailyAggregates *aggregates; /**< Revenue, margin and quantity per day, answering REVENUE and ITEMS. */
+    struct Stock stock; /**< Items in stock. */
+    struct Scheduler scheduler; /**< Waiting and running orders and the simulation clock. */
+    struct SimulationResult result; /**< Counters of the orders served from stock, blocked orders and idle days. */
+    struct Order *orders; /**< Every order received, the order id is the position in this array. */
+    int orders_count; /**< Number of orders received. */
+    int orders_capacity; /**< Allocated length of the orders array. */
+    uint64_t *from_stock; /**< One bit per order served from stock and not cancelled, orders_capacity bits. */
+    bool stopping; /**< Set by SHUTDOWN (or QUIT on a stream) to stop serving. */
+    char *snapshot_file_name; /**< Snapshot written by SNAPSHOT without a file name, NULL if there is none. */
+};
+
+void order_server_init(struct OrderServer *, struct SystemInfo *, struct ModelCatalog *, struct ModelOrderingStats *, struct InternTable *, struct DailyAggregates *, struct Order *, int, struct SimulationMetrics *, struct EventLog *, enum SchedulePolicy);
+void order_server_free(struct OrderServer *);
+void order_server_reserve(struct OrderServer *, int);
+enum ServerOrderStatus order_server_add(struct OrderServer *, struct Order *);
+int order_server_cancel(struct OrderServer *, int);
+int order_server_execute(struct OrderServer *, char *, char *, size_t);
+int order_server_serve_stream(struct OrderServer *, int, int);
+int order_server_serve_socket(struct OrderServer *, const char *);
+
+#endif //ORDER_SYSTEM_ORDER_SERVER_H
@@ -0,0 +1,172 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "order_sort.h"
+
+/**
+ * Allocates the key and permutation buffers for sorting the given number of orders.
+ * The permutation starts as the identity.
+ * @param keys Pointer reference to the SortKeys struct.
+ * @param count Number of orders to sort.
+ */
+void sort_keys_init(struct SortKeys *keys, int count) {
+    int i;
+    size_t n = count > 0 ? (size_t)count : 1;
+
+    keys->key = malloc(n * sizeof(uint64_t));
+    keys->index = malloc(n * sizeof(uint32_t));
+    keys->key_scratch = malloc(n * sizeof(uint64_t));
+    keys->index_scratch = malloc(n * sizeof(uint32_t));
+    keys->count = count;
+
+    if (keys->key == NULL || keys->index == NULL || keys->key_scratch == NULL || keys->index_scratch == NULL) {
+        printf("Error! not enough memory to sort %d orders\n", count);
+        exit(0);
+    }
+    for (i = 0; i < count; ++i) {
+        keys->index[i] = (uint32_t)i;
+    }
+}
+
+/**
+ * Releases the buffers of the SortKeys struct.
+ * @param keys Pointer reference to the SortKeys struct.
+ */
+void sort_keys_free(struct SortKeys *keys) {
+    free(keys->key);
+    free(keys->index);
+    free(keys->key_scratch);
+    free(keys->index_scratch);
+}
+
+/**
+ * Gives the number of bits needed to represent the value.
+ * @param value Value to measure.
+ * @return Returns the position of the highest set bit plus one, 0 for 0.
+ */
+int bits_needed(uint64_t value) {
+    int bits = 0;
+
+    while (value) {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+/**
+ * Stable LSD radix sort of the keys (and their permutation) on the lowest key_bits bits.
+ * Digits which are the same for every key are skipped, so narrow keys cost only a few passes.
+ * @param keys Pointer reference to the SortKeys struct.
+ * @param key_bits Number of significant bits in the keys.
+ */
+void radix_sort_keys(struct SortKeys *keys, int key_bits) {
+    static const int buckets = 1 << RADIX_BITS;
+    size_t counts[1 << RADIX_BITS];
+    int shift, i, n = keys->count;
+    uint64_t *tmp_key;
+    uint32_t *tmp_index;
+
+    for (shift = 0; shift < key_bits; shift += RADIX_BITS) {
+        size_t offset = 0;
+
+        memset(counts, 0, sizeof(counts));
+        for (i = 0; i < n; ++i) {
+            counts[(keys->key[i] >> shift) & (buckets - 1)]++;
+        }
+        if (n == 0 || counts[(keys->key[0] >> shift) & (buckets - 1)] == (size_t)n) {
+            continue;
+        }
+        for (i = 0; i < buckets; ++i) {
+            size_t bucket_count = counts[i];
+            counts[i] = offset;
+            offset += bucket_count;
+        }
+        for (i = 0; i < n; ++i) {
+            size_t slot = counts[(keys->key[i] >> shift) & (buckets - 1)]++;
+            keys->key_scratch[slot] = keys->key[i];
+            keys->index_scratch[slot] = keys->index[i];
+        }
+
+        tmp_key = keys->key;
+        keys->key = keys->key_scratch;
+        keys->key_scratch = tmp_key;
+        tmp_index = keys->index;
+        keys->index = keys->index_scratch;
+        keys->index_scratch = tmp_index;
+    }
+}
+
+/**
+ * Reorders the orders in place so that position i receives the order found at permutation[i].
+ * Each order is moved exactly once by following the cycles of the permutation, which is consumed.
+ * @param orders Pointer reference to the array of Order structs.
+ * @param permutation Source position of the order which goes to each position.
+ * @param orders_count Number of orders.
+ */
+void apply_permutation(struct Order *orders, uint32_t *permutation, int orders_count) {
+    int i;
+    uint32_t j, next;
+    struct Order temp;
+
+    for (i = 0; i < orders_count; ++i) {
+        if (permutation[i] == (uint32_t)i) {
+            continue;
+        }
+        temp = orders[i];
+        j = (uint32_t)i;
+        while (permutation[j] != (uint32_t)i) {
+            next = permutation[j];
+            orders[j] = orders[next];
+            permutation[j] = j;
+            j = next;
+        }
+        orders[j] = temp;
+        permutation[j] = j;
+    }
+}
+
+/**
+ * Margin of a model and its id, sorted to rank the models.
+ */
+struct ModelMargin {
+    float margin; /**< Price - cost of the model. */
+    int model_id; /**< Id of the model. */
+};
+
+/**
+ * Orders models by decreasing margin, for qsort.
+ */
+static int compare_margins(const void *a, const void *b) {
+    float x = ((const struct ModelMargin *)a)->margin, y = ((const struct ModelMargin *)b)->margin;
+
+    return (x < y) - (x > y);
+}
+
+/**
+ * Ranks the models by margin (price - cost), highest margin first. Models with the same margin share the rank,
+ * which is the number of models with a higher margin. Takes O(n log n) for n models.
+ * @param models Pointer reference to the array of ModelInfo structs.
+ * @param model_count Number of models.
+ * @param ranks Array of model_count entries indexed by model id which receives the rank.
+ */
+void model_margin_ranks(struct ModelInfo *models, int model_count, int *ranks) {
+    int i;
+    struct ModelMargin *margins = malloc((model_count > 0 ? model_count : 1) * sizeof(struct ModelMargin));
+
+    if (margins == NULL) {
+        printf("Error! not enough memory for %d models\n", model_count);
+        exit(0);
+    }
+    for (i = 0; i < model_count; ++i) {
+        margins[i].margin = models[i].price - models[i].cost;
+        margins[i].model_id = i;
+    }
+    qsort(margins, model_count, sizeof(struct ModelMargin), compare_margins);
+    for (i = 0; i < model_count; ++i) {
+        int rank = i > 0 && margins[i].margin == margins[i - 1].margin ? ranks[margins[i - 1].model_id] : i;
+        ranks[margins[i].model_id] = rank;
+    }
+    free(margins);
+}
@@ -0,0 +1,28 @@
+#ifndef ORDER_SYSTEM_ORDER_SORT_H
+#define ORDER_SYSTEM_ORDER_SORT_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "order_system.h"
+#define RADIX_BITS 11
+/** @file */
+
+/**
+ * Sort keys of the orders together with the permutation being built. key[i] belongs to the order at index[i].
+ */
+struct SortKeys {
+    uint64_t *key; /**< Composite key of each entry. */
+    uint32_t *index; /**< Original position of the order in the array. */
+    uint64_t *key_scratch; /**< Scratch buffer used by the radix passes. */
+    uint32_t *index_scratch; /**< Scratch buffer used by the radix passes. */
+    int count; /**< Number of entries. */
+};
+
+void sort_keys_init(struct SortKeys *, int);
+void sort_keys_free(struct SortKeys *);
+void radix_sort_keys(struct SortKeys *, int);
+void apply_permutation(struct Order *, uint32_t *, int);
+void model_margin_ranks(struct ModelInfo *, int, int *);
+int bits_needed(uint64_t);
+
+#endif //ORDER_SYSTEM_ORDER_SORT_H
@@ -0,0 +1,142 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "order_store.h"
+
+/**
+ * Allocates empty columns.
+ * @param columns Pointer reference to the OrderColumns struct.
+ * @param capacity Number of orders to reserve room for.
+ */
+void order_columns_init(struct OrderColumns *columns, int capacity) {
+    columns->capacity = capacity > 0 ? capacity : 1024;
+    columns->count = 0;
+    columns->timestamp = malloc(columns->capacity * sizeof(int));
+    columns->model_id = malloc(columns->capacity * sizeof(int));
+    columns->quantity = malloc(columns->capacity * sizeof(int));
+    columns->customer_id = malloc(columns->capacity * sizeof(int));
+
+    if (columns->timestamp == NULL || columns->model_id == NULL || columns->quantity == NULL || columns->customer_id == NULL) {
+        printf("Error! not enough memory for %d orders\n", columns->capacity);
+        exit(0);
+    }
+}
+
+/**
+ * Releases the columns.
+ * @param columns Pointer reference to the OrderColumns struct.
+ */
+void order_columns_free(struct OrderColumns *columns) {
+    free(columns->timestamp);
+    free(columns->model_id);
+    free(columns->quantity);
+    free(columns->customer_id);
+    columns->timestamp = columns->model_id = columns->quantity = columns->customer_id = NULL;
+}
+
+/**
+ * Builds the columns from an array of orders. The columns are initialised by this function.
+ * @param columns Pointer reference to the OrderColumns struct.
+ * @param orders Pointer reference to the array of Order structs.
+ * @param orders_count Number of orders.
+ * @param model_count Number of models, orders of models outside the catalog get this id.
+ */
+void order_columns_build(struct OrderColumns *columns, const struct Order *orders, int orders_count, int model_count) {
+    int i;
+
+    order_columns_init(columns, orders_count);
+    for (i = 0; i < orders_count; ++i) {
+        columns->timestamp[i] = orders[i].timestamp;
+        columns->model_id[i] = orders[i].model_id >= 0 && orders[i].model_id < model_count ? orders[i].model_id : model_count;
+        columns->quantity[i] = orders[i].quantity;
+        columns->customer_id[i] = orders[i].customer_id;
+    }
+    columns->count = orders_count;
+}
+
+/**
+ * Allocates zeroed per-model totals.
+ * @param totals Pointer reference to the ModelTotals struct.
+ * @param model_count Number of models.
+ */
+void model_totals_init(struct ModelTotals *totals, int model_count) {
+    totals->model_count = model_count;
+    totals->orders = calloc(model_count + 1, sizeof(long long));
+    totals->quantity = calloc(model_count + 1, sizeof(long long));
+
+    if (totals->orders == NULL || totals->quantity == NULL) {
+        printf("Error! not enough memory for %d models\n", model_count);
+        exit(0);
+    }
+}
+
+/**
+ * Releases the per-model totals.
+ * @param totals Pointer reference to the ModelTotals struct.
+ */
+void model_totals_free(struct ModelTotals *totals) {
+    free(totals->orders);
+    free(totals->quantity);
+}
+
+/**
+ * Adds up the number of orders and the quantity ordered for each model over the orders [from, to).
+ * The loop only touches the model and quantity columns and updates four interleaved histograms, so that
+ * consecutive orders of the same model do not wait on each other and the pass runs at memory speed.
+ * @param columns Pointer reference to the OrderColumns struct.
+ * @param from Position of the first order.
+ * @param to Position past the last order.
+ * @param totals Pointer reference to the ModelTotals struct receiving the sums.
+ */
+void order_columns_model_totals(struct OrderColumns *columns, int from, int to, struct ModelTotals *totals) {
+    int i, m, slots = totals->model_count + 1;
+    const int *restrict model_id = columns->model_id;
+    const int *restrict quantity = columns->quantity;
+    long long *partial = calloc(8 * (size_t)slots, sizeof(long long));
+    long long *orders = partial, *units = partial + 4 * slots;
+
+    if (partial == NULL) {
+        printf("Error! not enough memory for %d models\n", totals->model_count);
+        exit(0);
+    }
+
+    for (i = from; i + 4 <= to; i += 4) {
+        orders[model_id[i]]++;
+        units[model_id[i]] += quantity[i];
+        orders[slots + model_id[i + 1]]++;
+        units[slots + model_id[i + 1]] += quantity[i + 1];
+        orders[2 * slots + model_id[i + 2]]++;
+        units[2 * slots + model_id[i + 2]] += quantity[i + 2];
+        orders[3 * slots + model_id[i + 3]]++;
+        units[3 * slots + model_id[i + 3]] += quantity[i + 3];
+    }
+    for (; i < to; ++i) {
+        orders[model_id[i]]++;
+        units[model_id[i]] += quantity[i];
+    }
+
+    for (m = 0; m < slots; ++m) {
+        totals->orders[m] += orders[m] + orders[slots + m] + orders[2 * slots + m] + orders[3 * slots + m];
+        totals->quantity[m] += units[m] + units[slots + m] + units[2 * slots + m] + units[3 * slots + m];
+    }
+    free(partial);
+}
+
+/**
+ * Turns per-model quantities into revenue and margin. Orders of unknown models are not counted.
+ * @param totals Pointer reference to the ModelTotals struct.
+ * @param models Pointer reference to the array of ModelInfo structs.
+ * @param revenue Receives the revenue.
+ * @param margin Receives the margin (sale - cost).
+ */
+void model_totals_revenue_margin(struct ModelTotals *totals, struct ModelInfo *models, double *revenue, double *margin) {
+    int m;
+
+    *revenue = 0;
+    *margin = 0;
+    for (m = 0; m < totals->model_count; ++m) {
+        *revenue += (double)models[m].price * totals->quantity[m];
+        *margin += (double)(models[m].price - models[m].cost) * totals->quantity[m];
+    }
+}
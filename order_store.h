@@ -0,0 +1,38 @@
+#ifndef ORDER_SYSTEM_ORDER_STORE_H
+#define ORDER_SYSTEM_ORDER_STORE_H
+#include <stdio.h>
+#include <stdbool.h>
+#include "order_system.h"
+/** @file */
+
+/**
+ * Columnar (struct of arrays) copy of the orders used by the analytics passes.
+ * The hot fields have their own contiguous arrays, so a reduction only reads the bytes it needs.
+ */
+struct OrderColumns {
+    int *timestamp; /**< Time of each order, in days. */
+    int *model_id; /**< Position of the ordered model in the models array (model_count for unknown models). */
+    int *quantity; /**< Quantity of each order. */
+    int *customer_id; /**< Id of the customer of each order. */
+    int count; /**< Number of orders stored. */
+    int capacity; /**< Allocated length of each column. */
+};
+
+/**
+ * Result of a per-model reduction over a range of orders.
+ */
+struct ModelTotals {
+    long long *orders; /**< Number of orders of each model. */
+    long long *quantity; /**< Total quantity ordered of each model. */
+    int model_count; /**< Number of models. The arrays have one more slot, for orders of unknown models. */
+};
+
+void order_columns_init(struct OrderColumns *, int);
+void order_columns_free(struct OrderColumns *);
+void order_columns_build(struct OrderColumns *, const struct Order *, int, int);
+void model_totals_init(struct ModelTotals *, int);
+void model_totals_free(struct ModelTotals *);
+void order_columns_model_totals(struct OrderColumns *, int, int, struct ModelTotals *);
+void model_totals_revenue_margin(struct ModelTotals *, struct ModelInfo *, double *, double *);
+
+#endif //ORDER_SYSTEM_ORDER_STORE_H
@@ -0,0 +1,814 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "order_system.h"
+#include "order_reader.h"
+#include "order_merge.h"
+#include "order_sort.h"
+#include "scheduler.h"
+#include "order_store.h"
+#include "daily_stats.h"
+#include "stock.h"
+#include "work_pool.h"
+
+/**
+ * Reads the file of the name provided.
+ * @param fptr pointer to the FILE object
+ * @param name File name
+ */
+
+
+void read_file(FILE **fptr, char* name) {
+    if ((*fptr = fopen(name, "r")) == NULL) {
+        printf("Error! opening file %s\n", name);
+        exit(0);
+        // Program exits if file pointer returns NULL.
+    } else {
+        printf("File %s opened successfully\n", name);
+    }
+}
+
+/**
+ * Prepares an empty model catalog.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ */
+void model_catalog_init(struct ModelCatalog *catalog) {
+    catalog->models = NULL;
+    catalog->count = 0;
+    catalog->capacity = 0;
+    intern_table_init(&catalog->names);
+}
+
+/**
+ * Releases the memory of the model catalog.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ */
+void model_catalog_free(struct ModelCatalog *catalog) {
+    free(catalog->models);
+    catalog->models = NULL;
+    catalog->count = 0;
+    catalog->capacity = 0;
+    intern_table_free(&catalog->names);
+}
+
+/**
+ * Adds a model to the catalog, giving it the next model id.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param model Pointer reference to the ModelInfo struct to copy.
+ * @return Returns the id of the model, or -1 if a model with the same name is already in the catalog.
+ */
+int model_catalog_add(struct ModelCatalog *catalog, struct ModelInfo *model) {
+    size_t length = strnlen(model->model, MODEL_NAME_LENGTH - 1);
+    int id;
+
+    if (intern_table_find(&catalog->names, model->model, length) >= 0) {
+        return -1;
+    }
+    if (catalog->count == catalog->capacity) {
+        catalog->capacity = catalog->capacity > 0 ? catalog->capacity * 2 : 16;
+        catalog->models = realloc(catalog->models, catalog->capacity * sizeof(struct ModelInfo));
+        if (catalog->models == NULL) {
+            printf("Error! not enough memory for %d models\n", catalog->capacity);
+            exit(0);
+        }
+    }
+    id = intern_table_id(&catalog->names, model->model, length);
+    catalog->models[id] = *model;
+    catalog->models[id].model[length] = '\0';
+    catalog->count++;
+    return id;
+}
+
+/**
+ * Gives the name of a model.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param model_id Id of the model.
+ * @return Returns the model name, "?" for an id outside the catalog or without a catalog.
+ */
+const char *model_catalog_name(struct ModelCatalog *catalog, int model_id) {
+    return catalog != NULL && model_id >= 0 && model_id < catalog->count ? catalog->models[model_id].model : "?";
+}
+
+/**
+ * Prepares ordering stats with a zero counter for each model.
+ * @param stats Pointer reference to the ModelOrderingStats struct.
+ * @param model_count Number of models.
+ */
+void ordering_stats_init(struct ModelOrderingStats *stats, int model_count) {
+    stats->model_orders = calloc(model_count > 0 ? model_count : 1, sizeof(int));
+    stats->model_count = model_count;
+    stats->total_orders = 0;
+    if (stats->model_orders == NULL) {
+        printf("Error! not enough memory for %d models\n", model_count);
+        exit(0);
+    }
+}
+
+/**
+ * Releases the counters of the ordering stats.
+ * @param stats Pointer reference to the ModelOrderingStats struct.
+ */
+void ordering_stats_free(struct ModelOrderingStats *stats) {
+    free(stats->model_orders);
+    stats->model_orders = NULL;
+}
+
+/**
+ * Reads system information from the file into the SystemInfo struct
+ * @param fptr Pointer to file
+ * @param system_info Pointer to SystemInfo struct.
+ */
+void extract_system_info(FILE *fptr, struct SystemInfo *system_info) {
+    fscanf(fptr, "%d %d\n", &system_info->storage_capacity, &system_info->number_of_workers);
+}
+
+/**
+ * Reads models information from the file into the model catalog, one model per line until the end of the file.
+ * @param fptr Pointer to file
+ * @param catalog Pointer reference to the ModelCatalog struct receiving the models.
+ * @return Returns the number of models in the catalog.
+ */
+int extract_models_info(FILE *fptr, struct ModelCatalog *catalog) {
+    struct ModelInfo model;
+
+    memset(&model, 0, sizeof(model));
+    while (fscanf(fptr, "%19s %f %f %d %d", model.model, &model.cost, &model.price, &model.space_required, &model.man_hours) == 5) {
+        if (model_catalog_add(catalog, &model) < 0) {
+            printf("Model %s defined twice, skipping\n", model.model);
+        }
+    }
+    return catalog->count;
+}
+
+/**
+ * Reads customer orders from file into a growable list of Order structs.
+ * The file is read in chunks by an OrderReader, which fills the free end of the list one batch at a time, so there
+ * is no limit on the number of orders.
+ * @param fptr Pointer to file orders.dat
+ * @param orders Pointer to the array of Order structs, allocated (or grown) by this function.
+ * @param stats Pointer to ModelOrderingStats struct.
+ * @param catalog Pointer reference to the ModelCatalog struct which gives each model name its id.
+ * @param customers Pointer to the InternTable which gives each customer name its id.
+ * @return Returns the number of orders read from the file.
+ */
+int extract_orders_info(FILE *fptr, struct Order **orders, struct ModelOrderingStats *stats, struct ModelCatalog *catalog, struct InternTable *customers) {
+    int i = 0, j, read, capacity = 1024;
+    struct OrderReader reader;
+    struct Order *list = malloc(capacity * sizeof(struct Order));
+
+    order_reader_init(&reader, fptr, &catalog->names, customers);
+    while (list != NULL && (read = order_reader_read_batch(&reader, list + i, capacity - i)) > 0) {
+        for (j = i; j < i + read; ++j) {
+            update_ordering_stats(list[j].model_id, stats);
+        }
+        i += read;
+        if (i == capacity) {
+            capacity *= 2;
+            list = realloc(list, capacity * sizeof(struct Order));
+        }
+    }
+    order_reader_free(&reader);
+
+    if (list == NULL) {
+        printf("Error! not enough memory for %d orders\n", capacity);
+        exit(0);
+    }
+    *orders = list;
+    return i;
+}
+
+/**
+ * Reads the orders of several files, merged by timestamp with order_merge. The orders come out sorted by priority,
+ * as sort_by_priority would sort the files read one after the other, and customer ids are given in that order.
+ * @param names Names of the orders files.
+ * @param count Number of files.
+ * @param orders Pointer to the array of Order structs, allocated by this function.
+ * @param stats Pointer to ModelOrderingStats struct.
+ * @param catalog Pointer reference to the ModelCatalog struct which gives each model name its id.
+ * @param customers Pointer to the InternTable which gives each customer name its id.
+ * @return Returns the number of orders read from the files.
+ */
+int extract_merged_orders_info(char **names, int count, struct Order **orders, struct ModelOrderingStats *stats, struct ModelCatalog *catalog, struct InternTable *customers) {
+    int i = 0, capacity = 1024;
+    struct OrderMerge merge;
+    struct Order *list = malloc(capacity * sizeof(struct Order));
+
+    order_merge_open(&merge, names, count, catalog, customers);
+    while (list != NULL && order_merge_next(&merge, &list[i])) {
+        update_ordering_stats(list[i].model_id, stats);
+        i++;
+        if (i == capacity) {
+            capacity *= 2;
+            list = realloc(list, capacity * sizeof(struct Order));
+        }
+    }
+    order_merge_close(&merge);
+
+    if (list == NULL) {
+        printf("Error! not enough memory for %d orders\n", capacity);
+        exit(0);
+    }
+    *orders = list;
+    return i;
+}
+
+/**
+ * Shared state of a parallel load of an orders file.
+ */
+struct ParallelLoad {
+    struct OrderChunk *chunks; /**< Chunks of the file, in file order. */
+    int **customer_maps; /**< Global customer id of each local customer id, per chunk. */
+    int *first_order; /**< Position in the orders array of the first order of each chunk. */
+    struct InternTable *model_names; /**< Model names of the catalog, only read by the workers. */
+    int model_count; /**< Number of models of the catalog. */
+    struct Order *orders; /**< Merged orders. */
+};
+
+/**
+ * Work pool task parsing one chunk.
+ */
+static void parse_chunk_task(int task, int worker, void *context) {
+    struct ParallelLoad *load = context;
+
+    (void)worker;
+    order_chunk_parse(&load->chunks[task], load->model_names, load->model_count);
+}
+
+/**
+ * Work pool task copying the orders of one chunk to their final place with their global customer ids.
+ */
+static void merge_chunk_task(int task, int worker, void *context) {
+    struct ParallelLoad *load = context;
+    struct OrderChunk *chunk = &load->chunks[task];
+    struct Order *orders = load->orders + load->first_order[task];
+    int i, *customer_map = load->customer_maps[task];
+
+    (void)worker;
+    for (i = 0; i < chunk->count; ++i) {
+        orders[i] = chunk->orders[i];
+        orders[i].customer_id = customer_map[chunk->orders[i].customer_id];
+    }
+    free(chunk->orders);
+    chunk->orders = NULL;
+}
+
+/**
+ * Gives the start of the line following the given offset, or the end of the data.
+ */
+static size_t next_line_start(const char *data, size_t size, size_t offset) {
+    const char *newline;
+
+    if (offset == 0 || offset >= size) {
+        return offset < size ? offset : size;
+    }
+    newline = memchr(data + offset - 1, '\n', size - offset + 1);
+    return newline == NULL ? size : (size_t)(newline - data) + 1;
+}
+
+/**
+ * Reads the orders of the file provided on several threads and gives the same result as extract_orders_info: the
+ * same orders in the same order, the same customer ids (in order of first appearance in the file), the same ordering
+ * stats and the same messages for malformed lines. The file is mapped and split into newline aligned chunks of about
+ * ORDER_READER_CHUNK_SIZE bytes. Each chunk is parsed by a worker into its own orders, model counts and customer
+ * table; the customer tables are then merged in file order, which is what keeps the ids deterministic, and the
+ * orders are copied in place in parallel. Files which can not be mapped (pipes) or fit in one chunk are read by
+ * extract_orders_info.
+ * @param fptr Pointer to the orders file.
+ * @param orders Pointer to the array of Order structs, allocated by this function.
+ * @param stats Pointer to ModelOrderingStats struct.
+ * @param catalog Pointer reference to the ModelCatalog struct which gives each model name its id.
+ * @param customers Pointer to the InternTable which gives each customer name its id.
+ * @param threads Number of threads, 0 to use every core.
+ * @return Returns the number of orders read from the file.
+ */
+int extract_orders_info_parallel(FILE *fptr, struct Order **orders, struct ModelOrderingStats *stats, struct ModelCatalog *catalog, struct InternTable *customers, int threads) {
+    struct stat info;
+    struct ParallelLoad load;
+    size_t size, offset;
+    long long total = 0;
+    long line = 0;
+    int i, j, chunk_count;
+    char *data;
+
+    threads = work_pool_threads(threads);
+    if (threads == 1 || fstat(fileno(fptr), &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= ORDER_READER_CHUNK_SIZE
+        || ftell(fptr) != 0 || (data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fileno(fptr), 0)) == MAP_FAILED) {
+        return extract_orders_info(fptr, orders, stats, catalog, customers);
+    }
+    size = (size_t)info.st_size;
+    chunk_count = (int)((size + ORDER_READER_CHUNK_SIZE - 1) / ORDER_READER_CHUNK_SIZE);
+
+    load.chunks = calloc(chunk_count, sizeof(struct OrderChunk));
+    load.customer_maps = calloc(chunk_count, sizeof(int *));
+    load.first_order = malloc(chunk_count * sizeof(int));
+    load.model_names = &catalog->names;
+    load.model_count = catalog->count;
+    if (load.chunks == NULL || load.customer_maps == NULL || load.first_order == NULL) {
+        printf("Error! not enough memory for %d chunks\n", chunk_count);
+        exit(0);
+    }
+    for (i = 0, offset = 0; i < chunk_count; ++i) {
+        load.chunks[i].begin = data + offset;
+        offset = next_line_start(data, size, (size_t)((unsigned long long)size * (i + 1) / chunk_count));
+        load.chunks[i].end = data + offset;
+    }
+    work_pool_run(chunk_count, threads, parse_chunk_task, &load);
+
+    for (i = 0; i < chunk_count; ++i) {
+        struct OrderChunk *chunk = &load.chunks[i];
+
+        for (j = 0; j < chunk->malformed_count; ++j) {
+            printf("Malformed order on line %ld, skipping\n", line + chunk->malformed[j]);
+        }
+        line += chunk->lines;
+        for (j = 0; j < stats->model_count && j < load.model_count; ++j) {
+            stats->model_orders[j] += chunk->model_orders[j];
+        }
+        load.customer_maps[i] = malloc((chunk->customers.count > 0 ? chunk->customers.count : 1) * sizeof(int));
+        if (load.customer_maps[i] == NULL) {
+            printf("Error! not enough memory for %d customers\n", chunk->customers.count);
+            exit(0);
+        }
+        for (j = 0; j < chunk->customers.count; ++j) {
+            const char *name = intern_table_name(&chunk->customers, j);
+
+            load.customer_maps[i][j] = intern_table_id(customers, name, strlen(name));
+        }
+        load.first_order[i] = (int)total;
+        total += chunk->count;
+        if (total > INT_MAX) {
+            printf("Error! too many orders in the file\n");
+            exit(0);
+        }
+    }
+
+    load.orders = malloc((total > 0 ? (size_t)total : 1) * sizeof(struct Order));
+    if (load.orders == NULL) {
+        printf("Error! not enough memory for %lld orders\n", total);
+        exit(0);
+    }
+    work_pool_run(chunk_count, threads, merge_chunk_task, &load);
+
+    for (i = 0; i < chunk_count; ++i) {
+        order_chunk_free(&load.chunks[i]);
+        free(load.customer_maps[i]);
+    }
+    free(load.chunks);
+    free(load.customer_maps);
+    free(load.first_order);
+    munmap(data, size);
+    *orders = load.orders;
+    return (int)total;
+}
+
+/**
+ * Updates the number of orders placed by customer according to the item model provided.
+ * @param model_id Id of the item model, orders of models outside the catalog are not counted.
+ * @param orderingStats Pointer reference to the ModelOrderingStats data structure
+ */
+void update_ordering_stats(int model_id, struct ModelOrderingStats *orderingStats) {
+    if (model_id >= 0 && model_id < orderingStats->model_count) {
+        orderingStats->model_orders[model_id]++;
+    }
+}
+
+
+/**
+ * Gives reference to the model struct based on model name provided
+ * @param name Item model name
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @return Returns reference to the ModelInfo struct associated with the model provided, NULL for an unknown model.
+ */
+struct ModelInfo* get_model_by_name(const char *name, struct ModelCatalog *catalog) {
+    int id = intern_table_find(&catalog->names, name, strlen(name));
+
+    return id < 0 ? NULL : &catalog->models[id];
+}
+
+/**
+ * Sorts orders by priority: by timestamp, then by quantity (largest first) and then by the margin of the item model
+ * (largest first). A composite key is computed once for every order and the orders are sorted through a permutation
+ * with a stable radix sort, so orders with the same key keep the order of the file and each order is moved only once.
+ * @param orders Pointer to the array of Order structs.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param orders_count Number of orders received by customers.
+ */
+void sort_by_priority(struct Order *orders, struct ModelCatalog *catalog, int orders_count) {
+    int i, *ranks = malloc((catalog->count > 0 ? catalog->count : 1) * sizeof(int));
+    int min_timestamp = orders_count > 0 ? orders[0].timestamp : 0, max_timestamp = min_timestamp, max_quantity = 0;
+    int timestamp_bits, quantity_bits, rank_bits;
+    struct SortKeys keys;
+
+    if (ranks == NULL) {
+        printf("Error! not enough memory for %d models\n", catalog->count);
+        exit(0);
+    }
+    model_margin_ranks(catalog->models, catalog->count, ranks);
+    for (i = 0; i < orders_count; ++i) {
+        if (orders[i].timestamp < min_timestamp) min_timestamp = orders[i].timestamp;
+        if (orders[i].timestamp > max_timestamp) max_timestamp = orders[i].timestamp;
+        if (orders[i].quantity > max_quantity) max_quantity = orders[i].quantity;
+    }
+    timestamp_bits = bits_needed((uint64_t)(max_timestamp - min_timestamp));
+    quantity_bits = bits_needed((uint64_t)max_quantity);
+    rank_bits = bits_needed((uint64_t)catalog->count);
+
+    sort_keys_init(&keys, orders_count);
+    for (i = 0; i < orders_count; ++i) {
+        keys.key[i] = ((uint64_t)(max_quantity - orders[i].quantity) << rank_bits)
+                      | (uint64_t)(orders[i].model_id >= 0 && orders[i].model_id < catalog->count ? ranks[orders[i].model_id] : catalog->count);
+    }
+    free(ranks);
+
+    if (timestamp_bits + quantity_bits + rank_bits <= 64) {
+        for (i = 0; i < orders_count; ++i) {
+            keys.key[i] |= (uint64_t)(orders[i].timestamp - min_timestamp) << (quantity_bits + rank_bits);
+        }
+        radix_sort_keys(&keys, timestamp_bits + quantity_bits + rank_bits);
+    } else {
+        /* The composite key does not fit in 64 bits: sort on the low part first, then stably on the timestamp. */
+        radix_sort_keys(&keys, quantity_bits + rank_bits);
+        for (i = 0; i < orders_count; ++i) {
+            keys.key[i] = (uint64_t)(orders[keys.index[i]].timestamp - min_timestamp);
+        }
+        radix_sort_keys(&keys, timestamp_bits);
+    }
+
+    apply_permutation(orders, keys.index, orders_count);
+    sort_keys_free(&keys);
+}
+
+/**
+ * Prepares items to be stored in the stock according to the sales percentage, for one day or a whole gap of days.
+ * Each item takes the man hours of its model out of the labour available, so no more items are made than the workers
+ * can build.
+ * Nothing is stocked before the first order or when the average item takes no space, as there is no share to follow.
+ * @param stats Pointer reference to the ModelOrderingStats struct.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param stock  Pointer reference to the stock struct.
+ * @param catalog Pointer reference to the ModelCatalog struct, which gives the man hours of each item.
+ * @param labour_hours Man hours available over the days.
+ * @param events Pointer reference to the EventLog receiving a record for each model stocked, NULL to skip them.
+ * @param day First day on which the items are prepared, only used for the event records.
+ * @return Returns the number of items stocked.
+ */
+int prepare_for_stock(struct ModelOrderingStats *stats, struct SystemInfo *system, struct Stock *stock, struct ModelCatalog *catalog, long long labour_hours, struct EventLog *events, int day) {
+    int m, total = 0, available_space;
+
+    if (system->average_product_size <= 0 || stats->total_orders <= 0) {
+        return 0;
+    }
+    available_space = (int)(stock_free_space(stock) / system->average_product_size);
+    for (m = 0; m < stats->model_count; ++m) {
+        int model_stocks = available_space * ((float)stats->model_orders[m]/stats->total_orders*100) / 100;
+        int man_hours = m < catalog->count ? catalog->models[m].man_hours : 0;
+        int stocked;
+
+        if (man_hours > 0 && model_stocks > labour_hours / man_hours) {
+            model_stocks = (int)(labour_hours / man_hours);
+        }
+        stocked = prepare_product_for_model(m, stock, model_stocks);
+        labour_hours -= (long long)stocked * (man_hours > 0 ? man_hours : 0);
+        total += stocked;
+        if (stocked > 0 && events != NULL) {
+            event_log_push(events, EVENT_ITEMS_STOCKED, m, day, -1, stocked, -1);
+        }
+    }
+    return total;
+}
+
+/**
+ * Prepares stock over a whole gap of days without orders in one step. The ordering stats do not change within the
+ * gap, so the gap is planned as one long day: each model gets its share of the free stock space, capped by what the
+ * labour of every day of the gap can build, in O(models) whatever the length of the gap. One message and one event
+ * cover the whole gap.
+ * @param stats Pointer reference to the ModelOrderingStats struct.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param stock Pointer reference to the Stock struct.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param labour_hours Man hours available on each day.
+ * @param log Where a message is printed for the gap, NULL to run silently.
+ * @param events Pointer reference to the EventLog receiving a record for the gap and each model stocked, NULL to skip them.
+ * @param first_day First day without orders.
+ * @param last_day Last day without orders.
+ */
+void prepare_for_idle_days(struct ModelOrderingStats *stats, struct SystemInfo *system, struct Stock *stock, struct ModelCatalog *catalog, long long labour_hours, FILE *log, struct EventLog *events, int first_day, int last_day) {
+    long long days = (long long)last_day - first_day + 1;
+
+    if (log != NULL) {
+        if (days == 1) {
+            fprintf(log, "No orders placed on %d\n", first_day);
+        } else {
+            fprintf(log, "No orders placed from %d to %d\n", first_day, last_day);
+        }
+        fprintf(log, "Prepare models for storing in stock\n");
+    }
+    if (events != NULL) {
+        event_log_push(events, EVENT_IDLE_DAYS, -1, first_day, -1, days < INT_MAX ? (int)days : INT_MAX, -1);
+    }
+    prepare_for_stock(stats, system, stock, catalog, labour_hours > LLONG_MAX / days ? LLONG_MAX : labour_hours * days, events, first_day);
+}
+
+/**
+ * Records a gap between orders in the result, as one range of days.
+ * @param result Pointer reference to the SimulationResult struct.
+ * @param first_day First day without orders.
+ * @param last_day Last day without orders.
+ */
+void simulation_result_add_idle_range(struct SimulationResult *result, int first_day, int last_day) {
+    if (result->idle_range_count == result->idle_range_capacity) {
+        result->idle_range_capacity = result->idle_range_capacity > 0 ? result->idle_range_capacity * 2 : 64;
+        result->idle_ranges = realloc(result->idle_ranges, result->idle_range_capacity * sizeof(struct DayRange));
+        if (result->idle_ranges == NULL) {
+            printf("Error! not enough memory for %d idle ranges\n", result->idle_range_capacity);
+            exit(0);
+        }
+    }
+    result->idle_ranges[result->idle_range_count].first_day = first_day;
+    result->idle_ranges[result->idle_range_count].last_day = last_day;
+    result->idle_range_count++;
+    result->idle_days += last_day - first_day + 1;
+}
+
+/**
+ * Releases the idle ranges of a simulation result.
+ * @param result Pointer reference to the SimulationResult struct.
+ */
+void simulation_result_free(struct SimulationResult *result) {
+    free(result->idle_ranges);
+    result->idle_ranges = NULL;
+    result->idle_range_count = 0;
+    result->idle_range_capacity = 0;
+}
+
+/**
+ * Manufacturers the products of the given model and adds them to the stock in one step, as many as fit.
+ * @param model_id Position of the model in the models array.
+ * @param stock Pointer reference to the Stock struct.
+ * @param product_to_prepare Number of products to prepare for this specific model.
+ * @return Returns the number of products added to the stock.
+ */
+int prepare_product_for_model(int model_id, struct Stock *stock, int product_to_prepare) {
+    if (model_id < 0 || model_id >= stock->model_count) {
+        return 0;
+    }
+    return stock_add(stock, model_id, product_to_prepare);
+}
+
+/**
+ * Gives the average size of the item for storing in the stock based on all the item models.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @return Returns average size of item, 0 for an empty catalog.
+ */
+int average_product_size(struct ModelCatalog *catalog) {
+  int i;
+  long long products_space_sum = 0;
+  
+  for(i = 0 ; i < catalog->count; ++i) {
+    products_space_sum += catalog->models[i].space_required;
+  }
+  
+  return catalog->count > 0 ? (int)(products_space_sum/catalog->count) : 0;
+}
+
+/**
+ * Simulates the order at position i: the days without orders since the previous order are used to prepare stock,
+ * each with the labour of every worker, busy or not, for HOURS_PER_DAY hours, and recorded as one idle range;
+ * then the order is served from stock or handed to the Scheduler.
+ * The scheduler is not run, so orders can be fed one at a time while the clock is driven by the caller.
+ * @param orders Pointer reference to the array of Order structs.
+ * @param i Position of the order to simulate, the orders before it must have been simulated already.
+ * @param stats Pointer reference to the ModelOrderingStats struct.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param stock Pointer reference to the Stock struct.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param scheduler Pointer reference to an initialised Scheduler struct.
+ * @param result Pointer reference to the SimulationResult struct whose counters and idle ranges are updated.
+ */
+void simulate_order(const struct Order *orders, int i, struct ModelOrderingStats *stats, struct SystemInfo *system, struct Stock *stock, struct ModelCatalog *catalog, struct Scheduler *scheduler, struct SimulationResult *result) {
+    int model_id = orders[i].model_id;
+    struct ModelInfo *model_info = model_id >= 0 && model_id < catalog->count ? &catalog->models[model_id] : NULL;
+
+    scheduler->catalog = catalog;
+    if (i > 0 && orders[i].timestamp - orders[i - 1].timestamp > 1) {
+        long long labour_hours = (long long)(system->number_of_workers + scheduler->busy_workers) * HOURS_PER_DAY;
+
+        simulation_result_add_idle_range(result, orders[i - 1].timestamp + 1, orders[i].timestamp - 1);
+        prepare_for_idle_days(stats, system, stock, catalog, labour_hours, scheduler->log, scheduler->event_log,
+                              orders[i - 1].timestamp + 1, orders[i].timestamp - 1);
+    }
+
+    if (model_info != NULL && scheduler->metrics != NULL) {
+        scheduler->metrics->stock_lookups++;
+    }
+    if (model_info != NULL && sold_item_from_stock(model_id, orders[i].quantity, stock)) {
+        result->orders_from_stock++;
+        if (scheduler->metrics != NULL) {
+            scheduler->metrics->stock_hits++;
+        }
+        if (scheduler->event_log != NULL) {
+            event_log_push(scheduler->event_log, EVENT_SOLD_FROM_STOCK, model_id, orders[i].timestamp, i, orders[i].quantity, orders[i].customer_id);
+        }
+        return;
+    }
+
+    if (model_info == NULL) {
+        if (scheduler->log != NULL) {
+            fprintf(scheduler->log, "Unknown model in order of %s, skipping\n", order_customer_name(scheduler->customers, orders[i].customer_id));
+        }
+        if (scheduler->event_log != NULL) {
+            event_log_push(scheduler->event_log, EVENT_UNKNOWN_MODEL, model_id, orders[i].timestamp, i, orders[i].quantity, orders[i].customer_id);
+        }
+        result->blocked_orders++;
+        return;
+    }
+    scheduler_submit(scheduler, i, model_id, scheduler_processing_hours(model_info, orders[i].quantity));
+}
+
+/**
+ * Runs the simulation of the customer orders without touching them, so several simulations can share the same orders.
+ * Every order goes through simulate_order and the scheduler is then run until every order it can process is completed.
+ * @param orders Pointer reference to the array of Order structs.
+ * @param orders_count Number of orders.
+ * @param stats Pointer reference to the ModelOrderingStats struct.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param stock Pointer reference to the Stock struct.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param scheduler Pointer reference to an initialised Scheduler struct, which prints the messages to its log and
+ * records the events to its event log.
+ * @param result Pointer reference to the SimulationResult struct receiving the outcome, released with
+ * simulation_result_free.
+ */
+void simulate_orders(const struct Order *orders, int orders_count, struct ModelOrderingStats *stats, struct SystemInfo *system, struct Stock *stock, struct ModelCatalog *catalog, struct Scheduler *scheduler, struct SimulationResult *result) {
+    int i;
+
+    memset(result, 0, sizeof(*result));
+    for (i = 0; i < orders_count; ++i) {
+        simulate_order(orders, i, stats, system, stock, catalog, scheduler, result);
+    }
+    simulation_finish(orders, system, scheduler, result);
+}
+
+/**
+ * Runs the orders still waiting or processing to completion and fills the makespan, throughput and counters of the
+ * result, once every order has gone through simulate_order.
+ * @param orders Pointer reference to the array of Order structs.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param scheduler Pointer reference to the Scheduler struct the orders were submitted to.
+ * @param result Pointer reference to the SimulationResult struct filled by simulate_order.
+ */
+void simulation_finish(const struct Order *orders, struct SystemInfo *system, struct Scheduler *scheduler, struct SimulationResult *result) {
+    scheduler_run(scheduler, orders, system, INT_MAX);
+
+    result->processed_orders = scheduler->processed;
+    result->blocked_orders += scheduler->ready_count;
+    result->makespan = scheduler->last_completion;
+    result->throughput = result->makespan > 0 ? (double)result->processed_orders / result->makespan : 0;
+}
+
+/**
+ * Processes the customer orders by using the already manufacturing items as well as making new items at spot.
+ * The simulation is event driven (see simulate_orders); the scheduler keeps nothing per order but its queues of
+ * waiting orders and the completion events of the running ones.
+ * @param orders Pointer reference to the array of Order structs.
+ * @param stats Pointer reference to the ModelOrderingStats struct.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param stock Pointer reference to the Stock struct.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @param customers Pointer reference to the customer InternTable, which gives the names printed to the log.
+ * @param log Where the start and completion of each order are printed, NULL to run silently.
+ * @param metrics Pointer reference to the SimulationMetrics struct to fill, NULL to skip the metrics.
+ * @param events Pointer reference to the EventLog receiving the events, NULL to skip the journal.
+ * @param policy Order in which waiting orders get the workers.
+ * @param result Pointer reference to the SimulationResult struct receiving the makespan, throughput and counters.
+ */
+void process_orders(struct Order *orders, struct ModelOrderingStats *stats, struct SystemInfo *system, struct Stock *stock, struct ModelCatalog *catalog, struct InternTable *customers, FILE *log, struct SimulationMetrics *metrics, struct EventLog *events, enum SchedulePolicy policy, struct SimulationResult *result) {
+    struct Scheduler scheduler;
+
+    scheduler_init(&scheduler, 1, log);
+    scheduler.customers = customers;
+    scheduler.metrics = metrics;
+    scheduler.event_log = events;
+    scheduler.policy = policy;
+    simulate_orders(orders, stats->total_orders, stats, system, stock, catalog, &scheduler, result);
+    scheduler_free(&scheduler);
+}
+
+
+/**
+ * Sells already made items from stock. The whole order quantity is taken, or nothing when not enough is stored.
+ * @param model_id Position of the item model in the models array.
+ * @param quantity Number of items ordered.
+ * @param stock Pointer reference to Stock struct
+ * @return True if the items were sold, otherwise false.
+ */
+
+bool sold_item_from_stock(int model_id, int quantity, struct Stock *stock) {
+    if (model_id < 0 || model_id >= stock->model_count) {
+        return false;
+    }
+    return stock_reserve(stock, model_id, quantity);
+}
+
+/**
+ * Gives the name of the customer of an order.
+ * @param customers Pointer reference to the customer InternTable, NULL gives an empty name.
+ * @param customer_id Id of the customer.
+ * @return Returns the null terminated name, empty for an id missing from the table.
+ */
+const char *order_customer_name(struct InternTable *customers, int customer_id) {
+    if (customers == NULL || customer_id < 0 || customer_id >= customers->count) {
+        return "";
+    }
+    return intern_table_name(customers, customer_id);
+}
+
+
+/**
+ * Calculates the amount of each item models sold to each customer.
+ * The stats are kept in an array indexed by the customer id assigned when the orders were read, and the counters of
+ * every customer share the same allocation, so freeing the returned array releases everything. Orders of an unknown
+ * model or of a customer id outside the table (-1 from a binary file or a snapshot) are not counted.
+ * @param orders Pointer reference to array of Order structs.
+ * @param itemSoldStats Pointer to the array of ItemSoldStats structs, allocated by this function.
+ * @param customers Pointer reference to the customer InternTable.
+ * @param orders_count Total orders placed by customer.
+ * @param model_count Number of models in the catalog.
+ * @return Returns the total number of unique customers to whom the items were sold.
+ */
+
+int calculate_items_sold_for_each_customer(const struct Order *orders, struct ItemSoldStats **itemSoldStats, struct InternTable *customers, int orders_count, int model_count) {
+    int i;
+    size_t customer_count = customers->count > 0 ? (size_t)customers->count : 1;
+    struct ItemSoldStats *stats = calloc(1, customer_count * sizeof(struct ItemSoldStats) + customer_count * (size_t)model_count * sizeof(int));
+    int *counters = (int *)(stats + customer_count);
+
+    if (stats == NULL) {
+        printf("Error! not enough memory for %d customers\n", customers->count);
+        exit(0);
+    }
+    for (i = 0; i < customers->count; ++i) {
+        stats[i].customer_id = i;
+        stats[i].model_products = counters + (size_t)i * model_count;
+    }
+
+    for(i = 0 ; i < orders_count ; ++i) {
+        if (orders[i].model_id >= 0 && orders[i].model_id < model_count && orders[i].customer_id >= 0 && orders[i].customer_id < customers->count) {
+            stats[orders[i].customer_id].model_products[orders[i].model_id]++;
+        }
+    }
+
+    *itemSoldStats = stats;
+    return customers->count;
+}
+
+/**
+ * Sorts by most recent orders. The sort is stable, so orders of the same day keep their relative order.
+ * @param orders Pointer referece to array of Order struct.
+ * @param orders_count Total orders placed by customers.
+ */
+
+void sort_by_day(struct Order *orders, int orders_count) {
+    int i;
+    int min_timestamp = orders_count > 0 ? orders[0].timestamp : 0, max_timestamp = min_timestamp;
+    struct SortKeys keys;
+
+    for (i = 0; i < orders_count; ++i) {
+        if (orders[i].timestamp < min_timestamp) min_timestamp = orders[i].timestamp;
+        if (orders[i].timestamp > max_timestamp) max_timestamp = orders[i].timestamp;
+    }
+
+    sort_keys_init(&keys, orders_count);
+    for (i = 0; i < orders_count; ++i) {
+        keys.key[i] = (uint64_t)(orders[i].timestamp - min_timestamp);
+    }
+    radix_sort_keys(&keys, bits_needed((uint64_t)(max_timestamp - min_timestamp)));
+
+    apply_permutation(orders, keys.index, orders_count);
+    sort_keys_free(&keys);
+}
+
+/**
+ * Calculate the stats over the last 12 months
+ * The sums come from the per-day Fenwick trees, so no order is read again.
+ * @param aggregates Pointer reference to the DailyAggregates struct holding every order.
+ * @param stats Pointer reference to the TwelveMonthStats struct.
+ */
+void calculate_twelve_month_stats(struct DailyAggregates *aggregates, struct TwelveMonthStats *stats) {
+    double revenue, margin;
+
+    if (aggregates->last_day < aggregates->first_day) {
+        return;
+    }
+    daily_aggregates_range(aggregates, aggregates->last_day - 365, aggregates->last_day, &revenue, &margin);
+    stats->revenue += llround(revenue);
+    stats->margin += llround(margin);
+}
+
+
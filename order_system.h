@@ -1,35 +1,45 @@
 #ifndef ORDER_SYSTEM_ORDER_SYSTEM_H
 #define ORDER_SYSTEM_ORDER_SYSTEM_H
-#define TOTAL_MODELS 4
-#define MAX_PRODUCTS 100
-#define MAX_ORDER_DAYS 5000
+#define MODEL_NAME_LENGTH 20
+#define CUSTOMER_NAME_LENGTH 20
+#define HOURS_PER_DAY 24
+#include "intern_table.h"
 /** @file */
 
 /**
- * Holds information for customer order including item model, item quantity, order time and customer name
+ * Holds information for customer order including item model, item quantity, order time and customer.
+ * The customer name is stored once in the customer InternTable and the start and end hours live in the Scheduler
+ * while simulating, so an order is 16 bytes whatever the length of the names.
  */
 struct Order {
     int timestamp; /**< Time of the order*/
-    char model; /**< Model of the item which can be A, B, C or D */
+    int model_id; /**< Id of the ordered model in the model catalog, -1 for a model missing from the catalog */
     int quantity; /**< Quantity of the item ordered */
-    char customer[20]; /**< Customer name who ordered the item */
-    int process_start_hour; /**< Order start hour */
-    int process_end_hour; /**< Order end hour */
-    int completed; /**< Order completed status */
-    int processing; /** Order processing status */
+    int customer_id; /**< Id of the customer in the customer table */
 };
 
 /**
  * Holds information related to the coffee models which can be manufactured including their cost, price etc
  */
 struct ModelInfo {
-    char model; /**< Model of the item */
+    char model[MODEL_NAME_LENGTH]; /**< Name of the item model */
     float cost; /**< Cost for the manufacturing of the item model. */
     float price; /**< Sale price of the item model. */
     int man_hours; /**< Man hours required to manufacture the item model. */
     int space_required; /**< Space required to the stack the 1 item of this model. */
 };
 
+/**
+ * Holds the item models read from info.dat. Each model name is resolved once to a dense id (its position in the
+ * models array), so the rest of the program indexes per-model data directly instead of searching by name.
+ */
+struct ModelCatalog {
+    struct ModelInfo *models; /**< Models, indexed by model id. */
+    int count; /**< Number of models. */
+    int capacity; /**< Allocated length of the models array. */
+    struct InternTable names; /**< Model names, the id of a name is its model id. */
+};
+
 /**
  * Holds information regarding the system including stock capacity in m^3 etc.
  */
@@ -37,71 +47,114 @@ struct SystemInfo {
     int storage_capacity; /**< Stock capacity in m^3 */
     int number_of_workers; /**< Number of workers available */
     int average_product_size; /**< Average size of the product for storing the stock. */
-    int days_without_orders[MAX_ORDER_DAYS]; /**< List of days on which there were no orders by customers */
-    int days_without_orders_index; /**< Index of array of days without orders */
 };
 
 /**
- * Holds information regarding the orders placed by customers for different models as well as total orders placed.
+ * Consecutive days, both included.
  */
-struct ModelOrderingStats {
-    int model_a_orders; /**< Number of orders placed for Model A. */
-    int model_b_orders; /**< Number of orders placed for Model B. */
-    int model_c_orders; /**< Number of orders placed for Model C. */
-    int model_d_orders; /**< Number of orders placed for Model D. */
-    int total_orders; /**< Number of total orders. */
+struct DayRange {
+    int first_day; /**< First day of the range. */
+    int last_day; /**< Last day of the range. */
 };
 
 /**
- * Holds information for product which needs to be stored in stock.
+ * Holds information regarding the orders placed by customers for different models as well as total orders placed.
  */
-struct Product {
-    char model; /**< Model of the item stored in stock. */
-    int quantity; /**< Quantity of the item stored in stock. */
+struct ModelOrderingStats {
+    int *model_orders; /**< Number of orders placed for each model, indexed by model id. */
+    int model_count; /**< Number of models. */
+    int total_orders; /**< Number of total orders. */
 };
 
 /**
- * Holds information for system stock.
+ * Holds information for system stock: the number of items stored for each model, indexed by model id.
  */
 struct Stock {
-    struct Product products[MAX_PRODUCTS]; /**< List of products currently stored in stock. */
-    int occupied_space; /**< Total space occupied by all the items currently stored in stock. */
-    int products_index; /**< Index of products list. */
+    int *quantity; /**< Number of items stored for each model. */
+    int *space_required; /**< Space required to store 1 item of each model. */
+    int model_count; /**< Number of models. */
+    long long occupied_space; /**< Total space occupied by all the items currently stored in stock. */
+    long long storage_capacity; /**< Stock capacity in m^3. */
 };
 
 /**
  * Holds information related to item models sold to each customer
  */
 struct ItemSoldStats {
-    char name[20]; /**< Customer name */
-    int model_a_products; /**< Number of model A products sold to this customer. */
-    int model_b_products; /**< Number of model B products sold to this customer. */
-    int model_c_products; /**< Number of model C products sold to this customer. */
-    int model_d_products; /**< Number of model D products sold to this customer. */
+    int customer_id; /**< Id of the customer in the customer table */
+    int *model_products; /**< Number of products of each model sold to this customer, indexed by model id. */
 };
 
+/**
+ * Order in which waiting orders get the workers. Whatever the policy, an order needs the man hours of its model in
+ * workers and keeps them for quantity * man_hours hours, and an order which does not fit is skipped in favour of
+ * orders which do.
+ */
+enum SchedulePolicy {
+    SCHEDULE_FCFS, /**< First come first served, by position in the orders array. */
+    SCHEDULE_SPT, /**< Shortest processing time first, then by position. */
+    SCHEDULE_MARGIN, /**< Highest margin per processing hour first (price - cost over man hours), then by position. */
+    SCHEDULE_POLICY_COUNT /**< Number of policies. */
+};
+
+/**
+ * Outcome of one simulation of the orders.
+ */
+struct SimulationResult {
+    int makespan; /**< Hour at which the last order was completed. */
+    double throughput; /**< Orders manufactured per hour of makespan. */
+    int processed_orders; /**< Number of orders manufactured by the workers. */
+    int orders_from_stock; /**< Number of orders served from stock. */
+    int blocked_orders; /**< Number of orders which could not be processed (unknown model or too few workers). */
+    int idle_days; /**< Number of days without orders, used to prepare stock. */
+    struct DayRange *idle_ranges; /**< Gaps between orders, one range of days without orders each, in order. */
+    int idle_range_count; /**< Number of idle ranges. */
+    int idle_range_capacity; /**< Allocated length of the idle_ranges array. */
+};
+
+struct OrderColumns;
+struct DailyAggregates;
+struct Scheduler;
+struct SimulationMetrics;
+struct EventLog;
+
 /**
  * Holds information of last twelve months
  */
 struct TwelveMonthStats {
-    int revenue; /**< Revenue over the last 12 months. */
-    int margin; /**< Margin (sale - cost) over the last 12 months. */
+    long long revenue; /**< Revenue over the last 12 months. */
+    long long margin; /**< Margin (sale - cost) over the last 12 months. */
 };
 
+void read_file(FILE **, char *);
+void model_catalog_init(struct ModelCatalog *);
+void model_catalog_free(struct ModelCatalog *);
+int model_catalog_add(struct ModelCatalog *, struct ModelInfo *);
+const char *model_catalog_name(struct ModelCatalog *, int);
+void ordering_stats_init(struct ModelOrderingStats *, int);
+void ordering_stats_free(struct ModelOrderingStats *);
 void extract_system_info(FILE *, struct SystemInfo *);
-void extract_models_info(FILE *, struct ModelInfo *);
-int extract_orders_info(FILE *fptr, struct Order *, int, struct ModelOrderingStats *);
-void update_ordering_stats(char, struct ModelOrderingStats *);
-struct ModelInfo* get_model_by_name(char, struct ModelInfo *);
-void sort_by_priority(struct Order *, struct ModelInfo *, int);
-void prepare_for_stock(struct ModelOrderingStats *, struct SystemInfo *, struct Stock *, struct ModelInfo *);
-int prepare_product_for_model(char, struct ModelInfo *, struct Stock *, struct SystemInfo *, int, int);
-int average_product_size(struct ModelInfo *);
-void process_orders(struct Order *, struct ModelOrderingStats *, struct SystemInfo *, struct Stock *, struct ModelInfo *);
-bool sold_item_from_stock(char model, struct Stock *stock);
-struct ItemSoldStats * get_stats_from_customer_name(char *, struct ItemSoldStats *, int);
-int calculate_items_sold_for_each_customer(struct Order *, struct ItemSoldStats *, int );
+int extract_models_info(FILE *, struct ModelCatalog *);
+int extract_orders_info(FILE *fptr, struct Order **, struct ModelOrderingStats *, struct ModelCatalog *, struct InternTable *);
+int extract_merged_orders_info(char **, int, struct Order **, struct ModelOrderingStats *, struct ModelCatalog *, struct InternTable *);
+int extract_orders_info_parallel(FILE *, struct Order **, struct ModelOrderingStats *, struct ModelCatalog *, struct InternTable *, int);
+void update_ordering_stats(int, struct ModelOrderingStats *);
+struct ModelInfo* get_model_by_name(const char *, struct ModelCatalog *);
+void sort_by_priority(struct Order *, struct ModelCatalog *, int);
+int prepare_for_stock(struct ModelOrderingStats *, struct SystemInfo *, struct Stock *, struct ModelCatalog *, long long, struct EventLog *, int);
+void prepare_for_idle_days(struct ModelOrderingStats *, struct SystemInfo *, struct Stock *, struct ModelCatalog *, long long, FILE *, struct EventLog *, int, int);
+void simulation_result_add_idle_range(struct SimulationResult *, int, int);
+void simulation_result_free(struct SimulationResult *);
+int prepare_product_for_model(int, struct Stock *, int);
+int average_product_size(struct ModelCatalog *);
+void simulate_order(const struct Order *, int, struct ModelOrderingStats *, struct SystemInfo *, struct Stock *, struct ModelCatalog *, struct Scheduler *, struct SimulationResult *);
+void simulate_orders(const struct Order *, int, struct ModelOrderingStats *, struct SystemInfo *, struct Stock *, struct ModelCatalog *, struct Scheduler *, struct SimulationResult *);
+void simulation_finish(const struct Order *, struct SystemInfo *, struct Scheduler *, struct SimulationResult *);
+void process_orders(struct Order *, struct ModelOrderingStats *, struct SystemInfo *, struct Stock *, struct ModelCatalog *, struct InternTable *, FILE *, struct SimulationMetrics *, struct EventLog *, enum SchedulePolicy, struct SimulationResult *);
+bool sold_item_from_stock(int, int, struct Stock *);
+const char *order_customer_name(struct InternTable *, int);
+int calculate_items_sold_for_each_customer(const struct Order *, struct ItemSoldStats **, struct InternTable *, int, int);
 void sort_by_day(struct Order *, int);
-void calculate_twelve_month_stats(struct Order *, struct ModelInfo *, struct TwelveMonthStats *, int);
+void calculate_twelve_month_stats(struct DailyAggregates *, struct TwelveMonthStats *);
 
 #endif //ORDER_SYSTEM_ORDER_SYSTEM_H
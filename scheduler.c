@@ -0,0 +1,567 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "scheduler.h"
+
+static const char *policy_names[SCHEDULE_POLICY_COUNT] = {"fcfs", "spt", "margin"};
+
+/**
+ * Gives the name of a scheduling policy, as accepted by schedule_policy_parse.
+ * @param policy Scheduling policy.
+ * @return Returns the name of the policy.
+ */
+const char *schedule_policy_name(enum SchedulePolicy policy) {
+    return policy >= 0 && policy < SCHEDULE_POLICY_COUNT ? policy_names[policy] : "unknown";
+}
+
+/**
+ * Finds a scheduling policy by its name: fcfs, spt or margin.
+ * @param name Name of the policy.
+ * @return Returns the policy, or -1 if the name is unknown.
+ */
+int schedule_policy_parse(const char *name) {
+    int i;
+
+    for (i = 0; i < SCHEDULE_POLICY_COUNT; ++i) {
+        if (strcmp(name, policy_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Prepares an empty scheduler.
+ * @param scheduler Pointer reference to the Scheduler struct.
+ * @param start_hour Hour at which the simulation starts.
+ * @param log Where start and completion messages are printed, NULL to run silently.
+ */
+void scheduler_init(struct Scheduler *scheduler, int start_hour, FILE *log) {
+    scheduler->clock = start_hour;
+    scheduler->log = log;
+    scheduler->policy = SCHEDULE_FCFS;
+    scheduler->last_completion = start_hour;
+    scheduler->queues = NULL;
+    scheduler->queue_count = 0;
+    scheduler->slot_model = NULL;
+    scheduler->slot_workers = NULL;
+    scheduler->model_slot = NULL;
+    scheduler->tree = NULL;
+    scheduler->tree_size = 0;
+    scheduler->ranks = NULL;
+    scheduler->ready_count = 0;
+    scheduler->events = NULL;
+    scheduler->events_count = 0;
+    scheduler->events_capacity = 0;
+    scheduler->processed = 0;
+    scheduler->busy_workers = 0;
+    scheduler->metrics = NULL;
+    scheduler->catalog = NULL;
+    scheduler->event_log = NULL;
+    scheduler->customers = NULL;
+}
+
+/**
+ * Releases the memory of the scheduler.
+ * @param scheduler Pointer reference to the Scheduler struct.
+ */
+void scheduler_free(struct Scheduler *scheduler) {
+    int i;
+
+    for (i = 0; i < scheduler->queue_count; ++i) {
+        free(scheduler->queues[i].entries);
+    }
+    free(scheduler->queues);
+    free(scheduler->slot_model);
+    free(scheduler->slot_workers);
+    free(scheduler->model_slot);
+    free(scheduler->tree);
+    free(scheduler->ranks);
+    free(scheduler->events);
+    scheduler->queues = NULL;
+    scheduler->queue_count = 0;
+    scheduler->slot_model = NULL;
+    scheduler->slot_workers = NULL;
+    scheduler->model_slot = NULL;
+    scheduler->tree = NULL;
+    scheduler->ranks = NULL;
+    scheduler->events = NULL;
+}
+
+/**
+ * Gives the hours an order takes: its quantity times the man hours of its model, capped to INT_MAX - 1 hours.
+ * @param model Pointer reference to the ModelInfo struct of the ordered model.
+ * @param quantity Quantity ordered.
+ * @return Returns the processing hours of the order.
+ */
+int scheduler_processing_hours(struct ModelInfo *model, int quantity) {
+    long long hours = (long long)quantity * model->man_hours;
+
+    return hours < INT_MAX ? (int)hours : INT_MAX - 1;
+}
+
+/**
+ * Model with the value it is sorted by, for building the slots and the margin ranks.
+ */
+struct ModelKey {
+    double value; /**< Workers needed, or margin per processing hour negated so that the highest comes first. */
+    int model; /**< Id of the model. */
+};
+
+/**
+ * Sorts models by increasing value, then by model id.
+ */
+static int compare_model_keys(const void *a, const void *b) {
+    const struct ModelKey *x = a, *y = b;
+
+    if (x->value != y->value) {
+        return x->value < y->value ? -1 : 1;
+    }
+    return (x->model > y->model) - (x->model < y->model);
+}
+
+/**
+ * Margin per processing hour of a model, the weight of SCHEDULE_MARGIN: an order of any quantity earns
+ * quantity * (price - cost) in quantity * man_hours hours.
+ */
+static double margin_per_hour(struct ModelInfo *model) {
+    double margin = (double)model->price - model->cost;
+
+    if (model->man_hours <= 0) {
+        return margin >= 0 ? HUGE_VAL : -HUGE_VAL;
+    }
+    return margin / model->man_hours;
+}
+
+/**
+ * Builds an empty ready queue for each model of the catalog, the slots sorted by workers and the margin ranks.
+ * Models with the same margin per hour share their rank, so their orders are taken by position.
+ */
+static void queues_build(struct Scheduler *scheduler) {
+    struct ModelCatalog *catalog = scheduler->catalog;
+    int i, count = catalog != NULL ? catalog->count : 0;
+    size_t n = count > 0 ? (size_t)count : 1;
+    struct ModelKey *keys = malloc(n * sizeof(struct ModelKey));
+
+    scheduler->queues = calloc(n, sizeof(struct ReadyQueue));
+    scheduler->slot_model = malloc(n * sizeof(int));
+    scheduler->slot_workers = malloc(n * sizeof(int));
+    scheduler->model_slot = malloc(n * sizeof(int));
+    scheduler->ranks = malloc(n * sizeof(int));
+    for (scheduler->tree_size = 1; scheduler->tree_size < count; scheduler->tree_size *= 2) {
+    }
+    scheduler->tree = malloc(2 * (size_t)scheduler->tree_size * sizeof(int));
+    if (keys == NULL || scheduler->queues == NULL || scheduler->slot_model == NULL || scheduler->slot_workers == NULL
+        || scheduler->model_slot == NULL || scheduler->ranks == NULL || scheduler->tree == NULL) {
+        printf("Error! not enough memory for the scheduler\n");
+        exit(0);
+    }
+    scheduler->queue_count = count;
+    for (i = 0; i < 2 * scheduler->tree_size; ++i) {
+        scheduler->tree[i] = -1;
+    }
+
+    for (i = 0; i < count; ++i) {
+        scheduler->queues[i].workers = catalog->models[i].man_hours;
+        keys[i].value = catalog->models[i].man_hours;
+        keys[i].model = i;
+    }
+    qsort(keys, count, sizeof(struct ModelKey), compare_model_keys);
+    for (i = 0; i < count; ++i) {
+        scheduler->slot_model[i] = keys[i].model;
+        scheduler->slot_workers[i] = scheduler->queues[keys[i].model].workers;
+        scheduler->model_slot[keys[i].model] = i;
+    }
+
+    for (i = 0; i < count; ++i) {
+        keys[i].value = -margin_per_hour(&catalog->models[i]);
+        keys[i].model = i;
+    }
+    qsort(keys, count, sizeof(struct ModelKey), compare_model_keys);
+    for (i = 0; i < count; ++i) {
+        scheduler->ranks[keys[i].model] = i > 0 && keys[i].value == keys[i - 1].value ? scheduler->ranks[keys[i - 1].model] : i;
+    }
+    free(keys);
+}
+
+/**
+ * Gives the key of the best waiting order of a model, UINT64_MAX if it has none.
+ */
+static uint64_t head_key(struct Scheduler *scheduler, int model) {
+    return model >= 0 && scheduler->queues[model].count > 0 ? scheduler->queues[model].entries[0].key : UINT64_MAX;
+}
+
+/**
+ * Gives the model with the better waiting order of the two, -1 if neither has one.
+ */
+static int better_model(struct Scheduler *scheduler, int a, int b) {
+    if (a < 0 || head_key(scheduler, a) == UINT64_MAX) {
+        return b >= 0 && head_key(scheduler, b) != UINT64_MAX ? b : -1;
+    }
+    return b >= 0 && head_key(scheduler, b) < head_key(scheduler, a) ? b : a;
+}
+
+/**
+ * Updates the tree after the best waiting order of a model changed.
+ */
+static void tree_update(struct Scheduler *scheduler, int model) {
+    int node = scheduler->tree_size + scheduler->model_slot[model];
+
+    scheduler->tree[node] = scheduler->queues[model].count > 0 ? model : -1;
+    for (node /= 2; node >= 1; node /= 2) {
+        scheduler->tree[node] = better_model(scheduler, scheduler->tree[2 * node], scheduler->tree[2 * node + 1]);
+    }
+}
+
+/**
+ * Finds the model with the best waiting order among the models needing at most the given workers.
+ * @return Returns the model, or -1 if no waiting order fits.
+ */
+static int tree_best_fit(struct Scheduler *scheduler, int workers) {
+    int low = 0, high = scheduler->queue_count, left, right, best = -1;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+
+        if (scheduler->slot_workers[middle] <= workers) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (left = scheduler->tree_size, right = scheduler->tree_size + low; left < right; left /= 2, right /= 2) {
+        if (left & 1) {
+            best = better_model(scheduler, best, scheduler->tree[left++]);
+        }
+        if (right & 1) {
+            best = better_model(scheduler, best, scheduler->tree[--right]);
+        }
+    }
+    return best;
+}
+
+/**
+ * Adds a waiting order to the ready queue of its model.
+ */
+static void queue_push(struct ReadyQueue *queue, struct ReadyEntry entry) {
+    int i = queue->count++;
+
+    if (queue->count > queue->capacity) {
+        queue->capacity = queue->capacity > 0 ? queue->capacity * 2 : 16;
+        queue->entries = realloc(queue->entries, queue->capacity * sizeof(struct ReadyEntry));
+        if (queue->entries == NULL) {
+            printf("Error! not enough memory for the scheduler\n");
+            exit(0);
+        }
+    }
+    while (i > 0 && entry.key < queue->entries[(i - 1) / 2].key) {
+        queue->entries[i] = queue->entries[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    queue->entries[i] = entry;
+}
+
+/**
+ * Removes the best waiting order from a ready queue.
+ */
+static struct ReadyEntry queue_pop(struct ReadyQueue *queue) {
+    struct ReadyEntry top = queue->entries[0];
+    struct ReadyEntry last = queue->entries[--queue->count];
+    int i = 0, child;
+
+    while ((child = 2 * i + 1) < queue->count) {
+        if (child + 1 < queue->count && queue->entries[child + 1].key < queue->entries[child].key) {
+            child++;
+        }
+        if (last.key <= queue->entries[child].key) {
+            break;
+        }
+        queue->entries[i] = queue->entries[child];
+        i = child;
+    }
+    if (queue->count > 0) {
+        queue->entries[i] = last;
+    }
+    return top;
+}
+
+/**
+ * Sorts ready entries by key, for scheduler_waiting_orders.
+ */
+static int compare_ready_entries(const void *a, const void *b) {
+    const struct ReadyEntry *x = a, *y = b;
+
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+/**
+ * Gives the key of a waiting order under the policy of the scheduler. The position fills the low 32 bits, so keys
+ * are unique and equal priorities go first come first served.
+ */
+static uint64_t policy_key(struct Scheduler *scheduler, int order, int model, int hours) {
+    switch (scheduler->policy) {
+        case SCHEDULE_SPT:
+            return ((uint64_t)hours << 32) | (uint32_t)order;
+        case SCHEDULE_MARGIN:
+            return ((uint64_t)scheduler->ranks[model] << 32) | (uint32_t)order;
+        default:
+            return (uint32_t)order;
+    }
+}
+
+/**
+ * Puts a waiting order in the ready queue of its model.
+ */
+static void ready_add(struct Scheduler *scheduler, int order, int model, int hours, int submitted) {
+    struct ReadyEntry entry;
+
+    entry.key = policy_key(scheduler, order, model, hours);
+    entry.order = order;
+    entry.submitted = submitted;
+    queue_push(&scheduler->queues[model], entry);
+    if (scheduler->queues[model].entries[0].order == order) {
+        tree_update(scheduler, model);
+    }
+    scheduler->ready_count++;
+}
+
+/**
+ * Tells whether completion event a comes before completion event b.
+ */
+static int event_before(struct CompletionEvent *a, struct CompletionEvent *b) {
+    return a->end_hour < b->end_hour || (a->end_hour == b->end_hour && a->order < b->order);
+}
+
+/**
+ * Adds a completion event to the heap.
+ */
+static void events_push(struct Scheduler *scheduler, struct CompletionEvent event) {
+    int i = scheduler->events_count++;
+
+    if (scheduler->events_count > scheduler->events_capacity) {
+        scheduler->events_capacity = scheduler->events_capacity > 0 ? scheduler->events_capacity * 2 : 64;
+        scheduler->events = realloc(scheduler->events, scheduler->events_capacity * sizeof(struct CompletionEvent));
+        if (scheduler->events == NULL) {
+            printf("Error! not enough memory for the scheduler\n");
+            exit(0);
+        }
+    }
+    while (i > 0 && event_before(&event, &scheduler->events[(i - 1) / 2])) {
+        scheduler->events[i] = scheduler->events[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    scheduler->events[i] = event;
+}
+
+/**
+ * Removes the earliest completion event from the heap.
+ */
+static struct CompletionEvent events_pop(struct Scheduler *scheduler) {
+    struct CompletionEvent top = scheduler->events[0];
+    struct CompletionEvent last = scheduler->events[--scheduler->events_count];
+    int i = 0, child;
+
+    while ((child = 2 * i + 1) < scheduler->events_count) {
+        if (child + 1 < scheduler->events_count && event_before(&scheduler->events[child + 1], &scheduler->events[child])) {
+            child++;
+        }
+        if (!event_before(&scheduler->events[child], &last)) {
+            break;
+        }
+        scheduler->events[i] = scheduler->events[child];
+        i = child;
+    }
+    if (scheduler->events_count > 0) {
+        scheduler->events[i] = last;
+    }
+    return top;
+}
+
+/**
+ * Puts an order in the ready queue of its model, submitted at the current hour.
+ * @param scheduler Pointer reference to the Scheduler struct, whose catalog gives the models.
+ * @param order Position of the order in the orders array.
+ * @param model_id Id of the ordered model, whose man hours are the workers the order needs.
+ * @param hours Hours it takes to process the order, see scheduler_processing_hours.
+ */
+void scheduler_submit(struct Scheduler *scheduler, int order, int model_id, int hours) {
+    if (scheduler->queues == NULL) {
+        queues_build(scheduler);
+    }
+    ready_add(scheduler, order, model_id, hours, scheduler->clock);
+}
+
+/**
+ * Lists the waiting orders by increasing position, as saved by a snapshot.
+ * @param scheduler Pointer reference to the Scheduler struct.
+ * @param order Array of ready_count entries receiving the position of each waiting order.
+ * @param submitted Array of ready_count entries receiving the hour at which each was submitted.
+ * @return Returns the number of waiting orders, -1 if there is not enough memory.
+ */
+int scheduler_waiting_orders(struct Scheduler *scheduler, int *order, int *submitted) {
+    struct ReadyEntry *entries = malloc((scheduler->ready_count > 0 ? scheduler->ready_count : 1) * sizeof(struct ReadyEntry));
+    int i, m, count = 0;
+
+    if (entries == NULL) {
+        return -1;
+    }
+    for (m = 0; m < scheduler->queue_count; ++m) {
+        for (i = 0; i < scheduler->queues[m].count; ++i) {
+            entries[count] = scheduler->queues[m].entries[i];
+            entries[count++].key = (uint32_t)scheduler->queues[m].entries[i].order;
+        }
+    }
+    qsort(entries, count, sizeof(struct ReadyEntry), compare_ready_entries);
+    for (i = 0; i < count; ++i) {
+        order[i] = entries[i].order;
+        submitted[i] = entries[i].submitted;
+    }
+    free(entries);
+    return count;
+}
+
+/**
+ * Puts back the orders of a saved scheduler, for instance the ones of a snapshot. The waiting orders go back to the
+ * ready queues of their models and the completion events, saved in heap order, are copied as they are. The clock
+ * and the other counters are plain fields, which the caller sets; the policy and the catalog must be set first.
+ * @param scheduler Pointer reference to an empty Scheduler struct.
+ * @param orders Pointer reference to the array of Order structs, which gives the model and the hours of each order.
+ * @param waiting Positions of the waiting orders, increasing.
+ * @param submitted Hour at which each waiting order was submitted.
+ * @param waiting_count Number of waiting orders.
+ * @param events Completion events of the running orders, in heap order.
+ * @param events_count Number of completion events.
+ */
+void scheduler_restore(struct Scheduler *scheduler, const struct Order *orders, const int *waiting, const int *submitted, int waiting_count, const struct CompletionEvent *events, int events_count) {
+    int i;
+
+    if (scheduler->queues == NULL) {
+        queues_build(scheduler);
+    }
+    scheduler->ready_count = 0;
+    for (i = 0; i < waiting_count; ++i) {
+        const struct Order *order = &orders[waiting[i]];
+
+        if (order->model_id >= 0 && order->model_id < scheduler->queue_count) {
+            ready_add(scheduler, waiting[i], order->model_id, scheduler_processing_hours(&scheduler->catalog->models[order->model_id], order->quantity), submitted[i]);
+        }
+    }
+
+    scheduler->events_count = 0;
+    if (events_count > scheduler->events_capacity) {
+        scheduler->events_capacity = events_count;
+        scheduler->events = realloc(scheduler->events, scheduler->events_capacity * sizeof(struct CompletionEvent));
+        if (scheduler->events == NULL) {
+            printf("Error! not enough memory for the scheduler\n");
+            exit(0);
+        }
+    }
+    for (i = 0; i < events_count; ++i) {
+        scheduler->events[i] = events[i];
+    }
+    scheduler->events_count = events_count;
+}
+
+/**
+ * Starts processing waiting orders at the current hour, best first under the policy of the scheduler, as long as
+ * there are enough workers. An order which does not fit is skipped in favour of orders which do.
+ * @param scheduler Pointer reference to the Scheduler struct.
+ * @param orders Pointer reference to the array of Order structs, which gives the hours of each order and the messages.
+ * @param system Pointer reference to the SystemInfo struct.
+ */
+void scheduler_dispatch(struct Scheduler *scheduler, const struct Order *orders, struct SystemInfo *system) {
+    int i, model, workers, hours;
+    long long end_hour;
+    struct ReadyEntry entry;
+    struct CompletionEvent event;
+
+    while (scheduler->ready_count > 0 && (model = tree_best_fit(scheduler, system->number_of_workers)) >= 0) {
+        entry = queue_pop(&scheduler->queues[model]);
+        i = entry.order;
+        tree_update(scheduler, model);
+        workers = scheduler->queues[model].workers;
+        hours = scheduler_processing_hours(&scheduler->catalog->models[model], orders[i].quantity);
+        scheduler->ready_count--;
+
+        system->number_of_workers -= workers;
+        scheduler->busy_workers += workers;
+        end_hour = (long long)scheduler->clock + hours;
+        if (end_hour > INT_MAX) {
+            end_hour = INT_MAX;
+        }
+        if (scheduler->metrics != NULL) {
+            histogram_record(&scheduler->metrics->wait_hours, scheduler->clock - entry.submitted);
+            histogram_record(&scheduler->metrics->turnaround_hours, end_hour - entry.submitted);
+        }
+        if (scheduler->event_log != NULL) {
+            event_log_push(scheduler->event_log, EVENT_ORDER_STARTED, orders[i].model_id, scheduler->clock, i, orders[i].quantity, orders[i].customer_id);
+        }
+        if (scheduler->log != NULL) {
+            fprintf(scheduler->log, "Started processing order of %d items of  Model %s by %s at %d\n", orders[i].quantity, model_catalog_name(scheduler->catalog, orders[i].model_id), order_customer_name(scheduler->customers, orders[i].customer_id), scheduler->clock);
+        }
+
+        event.end_hour = (int)end_hour;
+        event.order = i;
+        event.workers = workers;
+        events_push(scheduler, event);
+    }
+
+    if (scheduler->metrics != NULL) {
+        histogram_record(&scheduler->metrics->ready_depth, scheduler->ready_count);
+        scheduler->metrics->blocked_dispatches += scheduler->ready_count > 0;
+    }
+    if (scheduler->ready_count > 0 && scheduler->event_log != NULL) {
+        event_log_push(scheduler->event_log, EVENT_ORDERS_WAITING, -1, scheduler->clock, -1, scheduler->ready_count, -1);
+    }
+    if (scheduler->ready_count > 0 && scheduler->log != NULL) {
+        fprintf(scheduler->log, "Not enough workers available, waiting\n");
+    }
+}
+
+/**
+ * Runs the simulation from the current hour, jumping from one completion to the next, until there is nothing
+ * left to process or the next completion falls after until_hour.
+ * @param scheduler Pointer reference to the Scheduler struct.
+ * @param orders Pointer reference to the array of Order structs, which gives the hours of each order and the messages.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param until_hour Last hour to simulate, INT_MAX to run until every order is completed.
+ */
+void scheduler_run(struct Scheduler *scheduler, const struct Order *orders, struct SystemInfo *system, int until_hour) {
+    struct CompletionEvent event;
+
+    scheduler_dispatch(scheduler, orders, system);
+    while (scheduler->events_count > 0 && scheduler->events[0].end_hour <= until_hour) {
+        if (scheduler->metrics != NULL) {
+            metrics_record_interval(scheduler->metrics, scheduler->busy_workers, system->number_of_workers + scheduler->busy_workers, scheduler->events[0].end_hour - scheduler->clock);
+        }
+        scheduler->clock = scheduler->events[0].end_hour;
+
+        while (scheduler->events_count > 0 && scheduler->events[0].end_hour == scheduler->clock) {
+            event = events_pop(scheduler);
+            system->number_of_workers += event.workers;
+            scheduler->busy_workers -= event.workers;
+            scheduler->processed++;
+            scheduler->last_completion = scheduler->clock;
+            if (scheduler->event_log != NULL) {
+                event_log_push(scheduler->event_log, EVENT_ORDER_COMPLETED, orders[event.order].model_id, scheduler->clock, event.order, orders[event.order].quantity, orders[event.order].customer_id);
+            }
+            if (scheduler->log != NULL) {
+                fprintf(scheduler->log, "Completed Order of %d items of  Model %s by %s at %d\n", orders[event.order].quantity, model_catalog_name(scheduler->catalog, orders[event.order].model_id), order_customer_name(scheduler->customers, orders[event.order].customer_id), scheduler->clock);
+            }
+        }
+        scheduler_dispatch(scheduler, orders, system);
+    }
+
+    if (until_hour != INT_MAX && scheduler->clock < until_hour) {
+        if (scheduler->metrics != NULL) {
+            metrics_record_interval(scheduler->metrics, scheduler->busy_workers, system->number_of_workers + scheduler->busy_workers, until_hour - scheduler->clock);
+        }
+        scheduler->clock = until_hour;
+    }
+    if (scheduler->events_count == 0 && scheduler->ready_count > 0 && scheduler->log != NULL) {
+        fprintf(scheduler->log, "%d orders need more workers than available and can not be processed\n", scheduler->ready_count);
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef ORDER_SYSTEM_SCHEDULER_H
+#define ORDER_SYSTEM_SCHEDULER_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "order_system.h"
+#include "metrics.h"
+#include "event_log.h"
+/** @file */
+
+/**
+ * Completion of an order which is being processed.
+ */
+struct CompletionEvent {
+    int end_hour; /**< Hour at which the order is completed. */
+    int order; /**< Position of the order in the orders array. */
+    int workers; /**< Workers released when the order is completed. */
+};
+
+/**
+ * Waiting order in a ready queue.
+ */
+struct ReadyEntry {
+    uint64_t key; /**< Priority under the policy of the scheduler, smallest first; unique as it ends with the position. */
+    int order; /**< Position of the order in the orders array. */
+    int submitted; /**< Hour at which the order was submitted. */
+};
+
+/**
+ * Orders of one model waiting for workers, a min-heap by key. Every order of a model needs the same workers.
+ */
+struct ReadyQueue {
+    struct ReadyEntry *entries; /**< Heap of the waiting orders. */
+    int count; /**< Number of waiting orders. */
+    int capacity; /**< Allocated length of the entries array. */
+    int workers; /**< Workers needed by each order, the man hours of the model. */
+};
+
+/**
+ * Discrete event scheduler for the orders. Orders waiting for workers sit in one ready queue per model; the models
+ * are kept in a tournament tree sorted by the workers they need, so the best waiting order among the models which
+ * fit in the free workers is found in O(log models) and taken from its queue in O(log orders). Running orders sit in
+ * a min-heap of completion events, and the clock jumps from one completion to the next. Nothing is kept per order
+ * position: an order is waiting while it sits in a ready queue, running while it has a completion event and
+ * completed otherwise, and its processing hours are worked out again from the order when it starts.
+ */
+struct Scheduler {
+    int clock; /**< Current simulation hour. */
+    FILE *log; /**< Where start and completion messages are printed, NULL to run silently. */
+    enum SchedulePolicy policy; /**< Order in which waiting orders start, SCHEDULE_FCFS by default; set before the first submit. */
+    int last_completion; /**< Hour of the latest completion so far. */
+    struct ReadyQueue *queues; /**< Ready queue of each model, built from the catalog on first use. */
+    int queue_count; /**< Number of ready queues, the number of models. */
+    int *slot_model; /**< Models sorted by the workers they need. */
+    int *slot_workers; /**< Workers needed by the model of each slot, in increasing order. */
+    int *model_slot; /**< Slot of each model. */
+    int *tree; /**< Tournament tree over the slots holding the model with the best waiting order, -1 if none. */
+    int tree_size; /**< Number of leaves of the tree, always a power of two. */
+    int *ranks; /**< Rank of each model by margin per processing hour, for SCHEDULE_MARGIN. */
+    int ready_count; /**< Number of orders waiting for workers. */
+    struct CompletionEvent *events; /**< Min-heap of completion events, by end hour and then order position. */
+    int events_count; /**< Number of orders being processed. */
+    int events_capacity; /**< Allocated size of the events heap. */
+    int processed; /**< Number of orders completed so far. */
+    int busy_workers; /**< Workers processing orders. */
+    struct SimulationMetrics *metrics; /**< Metrics to fill while simulating, NULL (the default) to skip them. */
+    struct ModelCatalog *catalog; /**< Gives the model names of the log messages and the models of the ready queues, set by simulate_orders. */
+    struct EventLog *event_log; /**< Event journal receiving a record of each event, NULL (the default) to skip it. */
+    struct InternTable *customers; /**< Gives the customer names of the log messages, needed only with a log. */
+};
+
+const char *schedule_policy_name(enum SchedulePolicy);
+int schedule_policy_parse(const char *);
+void scheduler_init(struct Scheduler *, int, FILE *);
+void scheduler_free(struct Scheduler *);
+int scheduler_processing_hours(struct ModelInfo *, int);
+void scheduler_submit(struct Scheduler *, int, int, int);
+void scheduler_restore(struct Scheduler *, const struct Order *, const int *, const int *, int, const struct CompletionEvent *, int);
+int scheduler_waiting_orders(struct Scheduler *, int *, int *);
+void scheduler_dispatch(struct Scheduler *, const struct Order *, struct SystemInfo *);
+void scheduler_run(struct Scheduler *, const struct Order *, struct SystemInfo *, int);
+
+#endif //ORDER_SYSTEM_SCHEDULER_H
@@ -0,0 +1,481 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+#include "order_file.h"
+#include "stock.h"
+
+/**
+ * Writes one order column, gathered from the kept orders into a scratch buffer.
+ */
+static int write_order_column(FILE *fptr, uint64_t offset, struct OrderServer *server, const int *kept, int count, int32_t *column, size_t field) {
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        memcpy(&column[i], (const char *)&server->orders[kept[i]] + field, sizeof(int32_t));
+    }
+    return order_file_write_section(fptr, offset, column, (size_t)count * sizeof(int32_t));
+}
+
+/**
+ * Compares two order positions, for bsearch.
+ */
+static int compare_positions(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Gives the position of an order among the kept orders.
+ */
+static int kept_position(const int *kept, int count, int order) {
+    return (int)((int *)bsearch(&order, kept, count, sizeof(int), compare_positions) - kept);
+}
+
+/**
+ * Lists the positions of the orders to save: every order, or only the waiting and running ones and the latest one,
+ * which the next order needs to find the days without orders before it. The waiting orders are given increasing.
+ * @return Returns the number of positions, -1 if there is not enough memory.
+ */
+static int kept_orders(struct OrderServer *server, bool backlog_only, const int *waiting, int waiting_count, int **kept) {
+    struct Scheduler *scheduler = &server->scheduler;
+    int *running = malloc((scheduler->events_count > 0 ? scheduler->events_count : 1) * sizeof(int));
+    int i, r = 0, w = 0, count = 0;
+
+    *kept = malloc((server->orders_count > 0 ? server->orders_count : 1) * sizeof(int));
+    if (running == NULL || *kept == NULL) {
+        free(running);
+        return -1;
+    }
+    for (i = 0; i < scheduler->events_count; ++i) {
+        running[i] = scheduler->events[i].order;
+    }
+    qsort(running, scheduler->events_count, sizeof(int), compare_positions);
+    for (i = 0; i < server->orders_count; ++i) {
+        bool is_running = r < scheduler->events_count && running[r] == i, is_waiting = w < waiting_count && waiting[w] == i;
+
+        r += is_running;
+        w += is_waiting;
+        if (!backlog_only || is_running || is_waiting || i == server->orders_count - 1) {
+            (*kept)[count++] = i;
+        }
+    }
+    free(running);
+    return count;
+}
+
+/**
+ * Writes the whole state of a running server to a snapshot file: the free workers, the stock, the orders and which
+ * of them were served from stock, the waiting orders with their submission hour, the completion events of the running orders, the ordering stats, the daily aggregates, the customer
+ * names and the clock. The file is written next to its final name and renamed once complete, so a crash while
+ * writing leaves the previous snapshot intact. Errors go to the standard error, as the standard output may carry the
+ * replies of the server.
+ * With backlog_only, the completed orders are left out, except the latest one, so the file stays the size of the
+ * backlog however long the history; their effects remain in the counters, the stock and the aggregates. The kept
+ * orders are renumbered in order, so a restored server gives them other ids.
+ * @param name File name
+ * @param server Pointer reference to the OrderServer struct.
+ * @param backlog_only Whether to save only the waiting and running orders and the latest one.
+ * @return Returns 0 on success, -1 if the file could not be written.
+ */
+int snapshot_write(char *name, struct OrderServer *server, bool backlog_only) {
+    int i, status = 0, model_count = server->catalog->count, count;
+    struct Scheduler *scheduler = &server->scheduler;
+    struct DailyAggregates *aggregates = server->aggregates;
+    struct InternTable *customers = server->customers;
+    size_t column_size;
+    size_t days_size = ((size_t)aggregates->count + 1) * sizeof(double);
+    size_t model_day_total = 0, model_tree_total = 0;
+    size_t events_size = (size_t)scheduler->events_count * sizeof(struct CompletionEvent);
+    size_t ranges_size = (size_t)server->result.idle_range_count * sizeof(struct DayRange);
+    size_t temporary_length = strlen(name) + 5;
+    char *temporary_name = malloc(temporary_length);
+    struct SnapshotHeader header;
+    struct OrderFileModel *table = order_file_model_table(server->catalog);
+    int32_t *column = malloc((server->orders_count > 0 ? server->orders_count : 1) * sizeof(int32_t));
+    struct CompletionEvent *events = malloc((scheduler->events_count > 0 ? scheduler->events_count : 1) * sizeof(struct CompletionEvent));
+    uint64_t *name_offsets = malloc((customers->count > 0 ? customers->count : 1) * sizeof(uint64_t));
+    int32_t *model_day_counts = malloc((model_count > 0 ? model_count : 1) * sizeof(int32_t));
+    int *waiting = malloc((scheduler->ready_count > 0 ? scheduler->ready_count : 1) * sizeof(int));
+    int *submitted = malloc((scheduler->ready_count > 0 ? scheduler->ready_count : 1) * sizeof(int));
+    int *kept = NULL, waiting_count = -1;
+    uint64_t *from_stock = NULL;
+    size_t from_stock_size;
+    uint64_t model_days_offset, model_quantity_offset;
+    FILE *fptr = NULL;
+
+    if (waiting != NULL && submitted != NULL) {
+        waiting_count = scheduler_waiting_orders(scheduler, waiting, submitted);
+    }
+    count = waiting_count >= 0 ? kept_orders(server, backlog_only, waiting, waiting_count, &kept) : -1;
+    column_size = (size_t)(count > 0 ? count : 0) * sizeof(int32_t);
+    from_stock_size = ((size_t)(count > 0 ? count : 0) + 63) / 64 * sizeof(uint64_t);
+    from_stock = calloc(from_stock_size > 0 ? from_stock_size : 1, 1);
+    if (temporary_name != NULL) {
+        snprintf(temporary_name, temporary_length, "%s.tmp", name);
+        fptr = fopen(temporary_name, "wb");
+    }
+    if (fptr == NULL || table == NULL || column == NULL || events == NULL || name_offsets == NULL || model_day_counts == NULL || from_stock == NULL || count < 0) {
+        fprintf(stderr, "Error! writing file %s\n", name);
+        free(model_day_counts);
+        free(waiting);
+        free(submitted);
+        free(from_stock);
+        free(temporary_name);
+        free(table);
+        free(column);
+        free(events);
+        free(name_offsets);
+        free(kept);
+        if (fptr != NULL) {
+            fclose(fptr);
+        }
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.policy = scheduler->policy;
+    header.storage_capacity = server->system->storage_capacity;
+    header.free_workers = server->system->number_of_workers;
+    header.average_product_size = server->system->average_product_size;
+    header.model_count = model_count;
+    header.customer_count = customers->count;
+    header.order_count = count;
+    header.total_orders = server->stats->total_orders;
+    header.events_count = scheduler->events_count;
+    header.waiting_count = waiting_count;
+    header.clock = scheduler->clock;
+    header.last_completion = scheduler->last_completion;
+    header.processed = scheduler->processed;
+    header.busy_workers = scheduler->busy_workers;
+    header.orders_from_stock = server->result.orders_from_stock;
+    header.blocked_orders = server->result.blocked_orders;
+    header.idle_days = server->result.idle_days;
+    header.day_count = aggregates->count;
+    for (i = 0; i < model_count; ++i) {
+        model_day_counts[i] = aggregates->models[i].count;
+        model_day_total += (size_t)aggregates->models[i].count;
+        model_tree_total += aggregates->models[i].count > 0 ? (size_t)aggregates->models[i].count + 1 : 0;
+    }
+    header.model_day_total = model_day_total;
+    header.occupied_space = server->stock.occupied_space;
+    for (i = 0; i < customers->count; ++i) {
+        name_offsets[i] = customers->offsets[i];
+    }
+    for (i = 0; i < scheduler->events_count; ++i) {
+        events[i] = scheduler->events[i];
+        events[i].order = kept_position(kept, count, events[i].order);
+    }
+    for (i = 0; i < waiting_count; ++i) {
+        waiting[i] = kept_position(kept, count, waiting[i]);
+    }
+    for (i = 0; i < count; ++i) {
+        if ((server->from_stock[kept[i] / 64] >> (kept[i] % 64)) & 1) {
+            from_stock[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+
+    header.models_offset = order_file_align(sizeof(header));
+    header.stock_offset = order_file_align(header.models_offset + model_count * sizeof(struct OrderFileModel));
+    header.model_orders_offset = order_file_align(header.stock_offset + model_count * sizeof(int32_t));
+    header.timestamp_offset = order_file_align(header.model_orders_offset + model_count * sizeof(int32_t));
+    header.model_id_offset = order_file_align(header.timestamp_offset + column_size);
+    header.quantity_offset = order_file_align(header.model_id_offset + column_size);
+    header.customer_id_offset = order_file_align(header.quantity_offset + column_size);
+    header.waiting_offset = order_file_align(header.customer_id_offset + column_size);
+    header.submitted_offset = order_file_align(header.waiting_offset + (size_t)waiting_count * sizeof(int32_t));
+    header.from_stock_offset = order_file_align(header.submitted_offset + (size_t)waiting_count * sizeof(int32_t));
+    header.events_offset = order_file_align(header.from_stock_offset + from_stock_size);
+    header.days_offset = order_file_align(header.events_offset + events_size);
+    header.revenue_offset = order_file_align(header.days_offset + (size_t)aggregates->count * sizeof(int32_t));
+    header.margin_offset = order_file_align(header.revenue_offset + days_size);
+    header.model_day_counts_offset = order_file_align(header.margin_offset + days_size);
+    header.model_days_offset = order_file_align(header.model_day_counts_offset + model_count * sizeof(int32_t));
+    header.model_quantity_offset = order_file_align(header.model_days_offset + model_day_total * sizeof(int32_t));
+    header.idle_ranges_offset = order_file_align(header.model_quantity_offset + model_tree_total * sizeof(long long));
+    header.idle_range_count = (uint64_t)server->result.idle_range_count;
+    header.customer_names_offset = order_file_align(header.idle_ranges_offset + ranges_size);
+    header.customer_names_size = customers->arena_length;
+    header.file_size = header.customer_names_offset + customers->count * sizeof(uint64_t) + customers->arena_length;
+
+    status |= order_file_write_section(fptr, 0, &header, sizeof(header));
+    status |= order_file_write_section(fptr, header.models_offset, table, model_count * sizeof(struct OrderFileModel));
+    status |= order_file_write_section(fptr, header.stock_offset, server->stock.quantity, model_count * sizeof(int32_t));
+    status |= order_file_write_section(fptr, header.model_orders_offset, server->stats->model_orders, model_count * sizeof(int32_t));
+    status |= write_order_column(fptr, header.timestamp_offset, server, kept, count, column, offsetof(struct Order, timestamp));
+    status |= write_order_column(fptr, header.model_id_offset, server, kept, count, column, offsetof(struct Order, model_id));
+    status |= write_order_column(fptr, header.quantity_offset, server, kept, count, column, offsetof(struct Order, quantity));
+    status |= write_order_column(fptr, header.customer_id_offset, server, kept, count, column, offsetof(struct Order, customer_id));
+    status |= order_file_write_section(fptr, header.waiting_offset, waiting, (size_t)waiting_count * sizeof(int32_t));
+    status |= order_file_write_section(fptr, header.submitted_offset, submitted, (size_t)waiting_count * sizeof(int32_t));
+    status |= order_file_write_section(fptr, header.from_stock_offset, from_stock, from_stock_size);
+    status |= order_file_write_section(fptr, header.events_offset, events, events_size);
+    status |= order_file_write_section(fptr, header.days_offset, aggregates->days, (size_t)aggregates->count * sizeof(int32_t));
+    status |= order_file_write_section(fptr, header.revenue_offset, aggregates->revenue, days_size);
+    status |= order_file_write_section(fptr, header.margin_offset, aggregates->margin, days_size);
+    status |= order_file_write_section(fptr, header.model_day_counts_offset, model_day_counts, model_count * sizeof(int32_t));
+    model_days_offset = header.model_days_offset;
+    for (i = 0; i < model_count; ++i) {
+        status |= order_file_write_section(fptr, model_days_offset, aggregates->models[i].days, (size_t)model_day_counts[i] * sizeof(int32_t));
+        model_days_offset += (uint64_t)model_day_counts[i] * sizeof(int32_t);
+    }
+    model_quantity_offset = header.model_quantity_offset;
+    for (i = 0; i < model_count; ++i) {
+        if (model_day_counts[i] > 0) {
+            status |= order_file_write_section(fptr, model_quantity_offset, aggregates->models[i].quantity, ((size_t)model_day_counts[i] + 1) * sizeof(long long));
+            model_quantity_offset += ((uint64_t)model_day_counts[i] + 1) * sizeof(long long);
+        }
+    }
+    status |= order_file_write_section(fptr, header.idle_ranges_offset, server->result.idle_ranges, ranges_size);
+    status |= order_file_write_section(fptr, header.customer_names_offset, name_offsets, customers->count * sizeof(uint64_t));
+    status |= order_file_write_section(fptr, header.customer_names_offset + customers->count * sizeof(uint64_t), customers->arena, customers->arena_length);
+
+    if (fclose(fptr) != 0 || status != 0 || rename(temporary_name, name) != 0) {
+        fprintf(stderr, "Error! writing file %s\n", name);
+        remove(temporary_name);
+        status = -1;
+    }
+    free(temporary_name);
+    free(table);
+    free(column);
+    free(events);
+    free(name_offsets);
+    free(model_day_counts);
+    free(waiting);
+    free(submitted);
+    free(from_stock);
+    free(kept);
+    return status;
+}
+
+/**
+ * Checks that the day counts of the models add up to the days saved and that the days and trees of the models fit
+ * in the file.
+ */
+static bool model_days_fit(const struct SnapshotHeader *header, const char *data) {
+    const int32_t *counts = (const int32_t *)(data + header->model_day_counts_offset);
+    uint64_t days = 0, trees = 0;
+    int m;
+
+    for (m = 0; m < header->model_count; ++m) {
+        if (counts[m] < 0) {
+            return false;
+        }
+        days += (uint64_t)counts[m];
+        trees += counts[m] > 0 ? (uint64_t)counts[m] + 1 : 0;
+    }
+    return days == header->model_day_total
+           && order_file_section_fits(header->model_days_offset, days * sizeof(int32_t), header->file_size)
+           && order_file_section_fits(header->model_quantity_offset, trees * sizeof(long long), header->file_size);
+}
+
+/**
+ * Maps a snapshot file in memory and checks its header and the bounds of its sections.
+ * @param name File name
+ * @param snapshot Pointer reference to the MappedSnapshot struct to fill.
+ * @return Returns 0 on success, -1 if the file can not be mapped or is not a valid snapshot.
+ */
+int snapshot_map(char *name, struct MappedSnapshot *snapshot) {
+    int fd = open(name, O_RDONLY);
+    struct stat info;
+    const struct SnapshotHeader *header;
+    uint64_t column_size, model_size, days_size, names_size;
+    char *data;
+
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(struct SnapshotHeader)) {
+        printf("Error! opening file %s\n", name);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Error! mapping file %s\n", name);
+        return -1;
+    }
+
+    header = (const struct SnapshotHeader *)data;
+    column_size = (uint64_t)(header->order_count > 0 ? header->order_count : 0) * sizeof(int32_t);
+    model_size = (uint64_t)(header->model_count > 0 ? header->model_count : 0) * sizeof(int32_t);
+    days_size = ((uint64_t)(header->day_count > 0 ? header->day_count : 0) + 1) * sizeof(double);
+    names_size = (uint64_t)(header->customer_count > 0 ? header->customer_count : 0) * sizeof(uint64_t) + header->customer_names_size;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0
+        || header->version != SNAPSHOT_VERSION || header->policy >= SCHEDULE_POLICY_COUNT
+        || header->file_size != (uint64_t)info.st_size
+        || header->model_count < 0 || header->customer_count < 0 || header->order_count < 0
+        || header->events_count < 0 || header->events_count > header->order_count
+        || header->waiting_count < 0 || header->waiting_count > header->order_count
+        || header->day_count < 0
+        || !order_file_section_fits(header->models_offset, header->model_count * sizeof(struct OrderFileModel), header->file_size)
+        || !order_file_section_fits(header->stock_offset, model_size, header->file_size)
+        || !order_file_section_fits(header->model_orders_offset, model_size, header->file_size)
+        || !order_file_section_fits(header->timestamp_offset, column_size, header->file_size)
+        || !order_file_section_fits(header->model_id_offset, column_size, header->file_size)
+        || !order_file_section_fits(header->quantity_offset, column_size, header->file_size)
+        || !order_file_section_fits(header->customer_id_offset, column_size, header->file_size)
+        || !order_file_section_fits(header->waiting_offset, (uint64_t)header->waiting_count * sizeof(int32_t), header->file_size)
+        || !order_file_section_fits(header->submitted_offset, (uint64_t)header->waiting_count * sizeof(int32_t), header->file_size)
+        || !order_file_section_fits(header->from_stock_offset, (column_size / sizeof(int32_t) + 63) / 64 * sizeof(uint64_t), header->file_size)
+        || !order_file_section_fits(header->events_offset, header->events_count * sizeof(struct CompletionEvent), header->file_size)
+        || !order_file_section_fits(header->days_offset, (uint64_t)header->day_count * sizeof(int32_t), header->file_size)
+        || !order_file_section_fits(header->revenue_offset, days_size, header->file_size)
+        || !order_file_section_fits(header->margin_offset, days_size, header->file_size)
+        || !order_file_section_fits(header->model_day_counts_offset, model_size, header->file_size)
+        || !model_days_fit(header, data)
+        || header->idle_range_count > INT32_MAX
+        || !order_file_section_fits(header->idle_ranges_offset, header->idle_range_count * sizeof(struct DayRange), header->file_size)
+        || !order_file_section_fits(header->customer_names_offset, names_size, header->file_size)
+        || (header->customer_names_size > 0 && data[header->file_size - 1] != '\0')) {
+        printf("Error! %s is not a valid snapshot\n", name);
+        munmap(data, (size_t)info.st_size);
+        return -1;
+    }
+
+    snapshot->data = data;
+    snapshot->size = (size_t)info.st_size;
+    snapshot->header = header;
+    return 0;
+}
+
+/**
+ * Unmaps a snapshot file.
+ * @param snapshot Pointer reference to the MappedSnapshot struct.
+ */
+void snapshot_unmap(struct MappedSnapshot *snapshot) {
+    munmap(snapshot->data, snapshot->size);
+    snapshot->data = NULL;
+}
+
+/**
+ * Copies the system and model information of the snapshot, which are needed to prepare the server before
+ * snapshot_restore. The models keep the ids of the file.
+ * @param snapshot Pointer reference to the MappedSnapshot struct.
+ * @param system Pointer reference to the SystemInfo struct.
+ * @param catalog Pointer reference to an empty ModelCatalog struct receiving the models.
+ */
+void snapshot_system_info(struct MappedSnapshot *snapshot, struct SystemInfo *system, struct ModelCatalog *catalog) {
+    const char *data = snapshot->data;
+
+    system->storage_capacity = snapshot->header->storage_capacity;
+    system->number_of_workers = snapshot->header->free_workers;
+    system->average_product_size = snapshot->header->average_product_size;
+    order_file_add_models((const struct OrderFileModel *)(data + snapshot->header->models_offset), snapshot->header->model_count, catalog);
+}
+
+/**
+ * Puts the state saved in a snapshot back into a server started without orders, so it resumes exactly where the
+ * snapshot was taken. Every section is copied in one pass; nothing is replayed. The waiting orders go back to the
+ * ready queues under the given policy, so a server may resume with another policy than the one it was saved with;
+ * the running orders keep their hours.
+ * @param snapshot Pointer reference to the MappedSnapshot struct.
+ * @param server Pointer reference to an OrderServer struct started without orders, over the system, catalog and
+ * empty stats, customers and aggregates prepared from snapshot_system_info.
+ * @param policy Scheduling policy of the restored server, -1 to keep the policy of the snapshot.
+ */
+void snapshot_restore(struct MappedSnapshot *snapshot, struct OrderServer *server, int policy) {
+    int i;
+    const struct SnapshotHeader *header = snapshot->header;
+    const char *data = snapshot->data;
+    const uint64_t *name_offsets = (const uint64_t *)(data + header->customer_names_offset);
+    const char *names = data + header->customer_names_offset + header->customer_count * sizeof(uint64_t);
+    const int32_t *timestamp = (const int32_t *)(data + header->timestamp_offset);
+    const int32_t *model_id = (const int32_t *)(data + header->model_id_offset);
+    const int32_t *quantity = (const int32_t *)(data + header->quantity_offset);
+    const int32_t *customer_id = (const int32_t *)(data + header->customer_id_offset);
+    const struct CompletionEvent *events = (const struct CompletionEvent *)(data + header->events_offset);
+    const int32_t *waiting = (const int32_t *)(data + header->waiting_offset);
+    const uint64_t *from_stock = (const uint64_t *)(data + header->from_stock_offset);
+    const int32_t *days = (const int32_t *)(data + header->days_offset);
+    const int32_t *model_day_counts = (const int32_t *)(data + header->model_day_counts_offset);
+    const int32_t *days_of_models = (const int32_t *)(data + header->model_days_offset), *model_days;
+    struct Scheduler *scheduler = &server->scheduler;
+
+    for (i = 0; i < header->customer_count; ++i) {
+        const char *name = name_offsets[i] < header->customer_names_size ? names + name_offsets[i] : "";
+
+        if (intern_table_id(server->customers, name, strlen(name)) != i) {
+            printf("Error! customer %s saved twice in the snapshot\n", name);
+            exit(0);
+        }
+    }
+    for (i = 1; i < header->day_count; ++i) {
+        if (days[i - 1] >= days[i]) {
+            printf("Error! the days of the snapshot are not increasing\n");
+            exit(0);
+        }
+    }
+    for (i = 0, model_days = days_of_models; i < header->model_count; model_days += model_day_counts[i++]) {
+        int d;
+
+        for (d = 1; d < model_day_counts[i]; ++d) {
+            if (model_days[d - 1] >= model_days[d]) {
+                printf("Error! the days of the snapshot are not increasing\n");
+                exit(0);
+            }
+        }
+    }
+    for (i = 0; i < header->events_count; ++i) {
+        if (events[i].order < 0 || events[i].order >= header->order_count) {
+            printf("Error! the snapshot holds a running order out of range\n");
+            exit(0);
+        }
+    }
+    for (i = 0; i < header->waiting_count; ++i) {
+        if (waiting[i] < 0 || waiting[i] >= header->order_count || (i > 0 && waiting[i - 1] >= waiting[i])) {
+            printf("Error! the snapshot holds a waiting order out of range\n");
+            exit(0);
+        }
+    }
+
+    order_server_reserve(server, header->order_count > 1024 ? header->order_count : 1024);
+    server->orders_count = header->order_count;
+    for (i = 0; i < server->orders_count; ++i) {
+        struct Order *order = &server->orders[i];
+
+        order->timestamp = timestamp[i];
+        order->model_id = model_id[i] >= 0 && model_id[i] < header->model_count ? model_id[i] : -1;
+        order->quantity = quantity[i];
+        order->customer_id = customer_id[i] >= 0 && customer_id[i] < header->customer_count ? customer_id[i] : -1;
+        if ((from_stock[i / 64] >> (i % 64)) & 1) {
+            server->from_stock[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+
+    memcpy(server->stock.quantity, data + header->stock_offset, header->model_count * sizeof(int32_t));
+    server->stock.occupied_space = header->occupied_space;
+    memcpy(server->stats->model_orders, data + header->model_orders_offset, header->model_count * sizeof(int32_t));
+    server->stats->total_orders = header->total_orders;
+    daily_aggregates_load(server->aggregates, header->day_count, days, (const double *)(data + header->revenue_offset), (const double *)(data + header->margin_offset),
+                          model_day_counts, days_of_models, (const long long *)(data + header->model_quantity_offset));
+
+    scheduler->policy = (enum SchedulePolicy)(policy >= 0 && policy < SCHEDULE_POLICY_COUNT ? (uint32_t)policy : header->policy);
+    scheduler_restore(scheduler, server->orders, waiting, (const int *)(data + header->submitted_offset), header->waiting_count,
+                      events, header->events_count);
+    scheduler->clock = header->clock;
+    scheduler->last_completion = header->last_completion;
+    scheduler->processed = header->processed;
+    scheduler->busy_workers = header->busy_workers;
+
+    server->result.orders_from_stock = header->orders_from_stock;
+    server->result.blocked_orders = header->blocked_orders;
+    server->result.idle_days = header->idle_days;
+    server->result.idle_range_count = 0;
+    for (i = 0; i < (int)header->idle_range_count; ++i) {
+        const struct DayRange *range = (const struct DayRange *)(data + header->idle_ranges_offset) + i;
+
+        simulation_result_add_idle_range(&server->result, range->first_day, range->last_day);
+    }
+    server->result.idle_days = header->idle_days;
+}
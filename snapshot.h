@@ -0,0 +1,79 @@
+#ifndef ORDER_SYSTEM_SNAPSHOT_H
+#define ORDER_SYSTEM_SNAPSHOT_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "order_system.h"
+#include "order_server.h"
+#define SNAPSHOT_MAGIC "COFSNAP"
+#define SNAPSHOT_VERSION 7
+/** @file */
+
+/**
+ * Header at the start of a snapshot file. The sections use the layout rules of the binary order file: every offset
+ * is counted from the start of the file and aligned to ORDER_FILE_ALIGNMENT bytes, and the order columns hold
+ * order_count 32 bit integers each.
+ */
+struct SnapshotHeader {
+    char magic[8]; /**< SNAPSHOT_MAGIC, null terminated. */
+    uint32_t version; /**< SNAPSHOT_VERSION. */
+    uint32_t policy; /**< Scheduling policy of the server, an enum SchedulePolicy. */
+    uint64_t file_size; /**< Total size of the file, to detect truncated files. */
+    int32_t storage_capacity; /**< Stock capacity in m^3. */
+    int32_t free_workers; /**< Workers not processing an order. */
+    int32_t average_product_size; /**< Average size of a product, used to prepare stock. */
+    int32_t model_count; /**< Number of entries of the model table. */
+    int32_t customer_count; /**< Number of entries of the customer string table. */
+    int32_t order_count; /**< Number of orders received. */
+    int32_t total_orders; /**< ModelOrderingStats.total_orders. */
+    int32_t events_count; /**< Number of running orders, the entries of the completion events section. */
+    int32_t waiting_count; /**< Number of waiting orders, the entries of the waiting and submitted sections. */
+    int32_t clock; /**< Current simulation hour. */
+    int32_t last_completion; /**< Hour of the latest completion. */
+    int32_t processed; /**< Number of orders completed. */
+    int32_t busy_workers; /**< Workers processing orders. */
+    int32_t orders_from_stock; /**< Number of orders served from stock. */
+    int32_t blocked_orders; /**< Number of orders of unknown models. */
+    int32_t idle_days; /**< Number of days without orders used to prepare stock. */
+    int32_t day_count; /**< Number of days which have orders, the buckets of the daily aggregates. */
+    int64_t occupied_space; /**< Space taken by the items in stock. */
+    uint64_t models_offset; /**< Offset of the model table. */
+    uint64_t stock_offset; /**< Offset of the items in stock of each model (int32). */
+    uint64_t model_orders_offset; /**< Offset of the number of orders of each model (int32). */
+    uint64_t timestamp_offset; /**< Offset of the timestamp column. */
+    uint64_t model_id_offset; /**< Offset of the model id column. */
+    uint64_t quantity_offset; /**< Offset of the quantity column. */
+    uint64_t customer_id_offset; /**< Offset of the customer id column. */
+    uint64_t waiting_offset; /**< Offset of the positions of the waiting orders, increasing (int32). */
+    uint64_t submitted_offset; /**< Offset of the hour at which each waiting order was submitted (int32). */
+    uint64_t from_stock_offset; /**< Offset of the bits of the orders served from stock and not cancelled, order_count bits in uint64 words. */
+    uint64_t events_offset; /**< Offset of the completion events of the running orders, in heap order. */
+    uint64_t days_offset; /**< Offset of the days which have orders, increasing (int32). */
+    uint64_t revenue_offset; /**< Offset of the Fenwick tree of the daily revenue (day_count + 1 doubles). */
+    uint64_t margin_offset; /**< Offset of the Fenwick tree of the daily margin (day_count + 1 doubles). */
+    uint64_t model_day_counts_offset; /**< Offset of the number of days which have orders of each model (int32). */
+    uint64_t model_days_offset; /**< Offset of the days of each model one after the other, increasing for each model (int32). */
+    uint64_t model_quantity_offset; /**< Offset of the Fenwick trees of the quantity of the models which have orders, one after the other, days + 1 int64 each. */
+    uint64_t model_day_total; /**< Number of days which have orders, summed over the models. */
+    uint64_t customer_names_offset; /**< Offset of the customer string table (offset array followed by the names). */
+    uint64_t customer_names_size; /**< Size in bytes of the null terminated names. */
+    uint64_t idle_ranges_offset; /**< Offset of the ranges of days without orders (DayRange). */
+    uint64_t idle_range_count; /**< Number of ranges of days without orders. */
+};
+
+/**
+ * Snapshot file mapped in memory, read only.
+ */
+struct MappedSnapshot {
+    void *data; /**< Start of the mapping. */
+    size_t size; /**< Size of the mapping. */
+    const struct SnapshotHeader *header; /**< Header of the file. */
+};
+
+int snapshot_write(char *, struct OrderServer *, bool);
+int snapshot_map(char *, struct MappedSnapshot *);
+void snapshot_unmap(struct MappedSnapshot *);
+void snapshot_system_info(struct MappedSnapshot *, struct SystemInfo *, struct ModelCatalog *);
+void snapshot_restore(struct MappedSnapshot *, struct OrderServer *, int);
+
+#endif //ORDER_SYSTEM_SNAPSHOT_H
@@ -0,0 +1,100 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include "stock.h"
+
+/**
+ * Prepares an empty stock with one slot per model.
+ * @param stock Pointer reference to the Stock struct.
+ * @param storage_capacity Stock capacity in m^3.
+ * @param models Pointer reference to the array of ModelInfo structs, model ids index it.
+ * @param model_count Number of models.
+ */
+void stock_init(struct Stock *stock, int storage_capacity, struct ModelInfo *models, int model_count) {
+    int m;
+
+    stock->model_count = model_count;
+    stock->storage_capacity = storage_capacity;
+    stock->occupied_space = 0;
+    stock->quantity = calloc(model_count > 0 ? model_count : 1, sizeof(int));
+    stock->space_required = malloc((model_count > 0 ? model_count : 1) * sizeof(int));
+
+    if (stock->quantity == NULL || stock->space_required == NULL) {
+        printf("Error! not enough memory for the stock of %d models\n", model_count);
+        exit(0);
+    }
+    for (m = 0; m < model_count; ++m) {
+        stock->space_required[m] = models[m].space_required;
+    }
+}
+
+/**
+ * Releases the memory of the stock.
+ * @param stock Pointer reference to the Stock struct.
+ */
+void stock_free(struct Stock *stock) {
+    free(stock->quantity);
+    free(stock->space_required);
+    stock->quantity = NULL;
+    stock->space_required = NULL;
+}
+
+/**
+ * Gives the space still free in the stock.
+ * @param stock Pointer reference to the Stock struct.
+ * @return Returns the free space in m^3.
+ */
+long long stock_free_space(struct Stock *stock) {
+    long long free_space = stock->storage_capacity - stock->occupied_space;
+
+    return free_space > 0 ? free_space : 0;
+}
+
+/**
+ * Stores up to the given number of items of a model, as many as fit in the free space.
+ * @param stock Pointer reference to the Stock struct.
+ * @param model_id Position of the model in the models array.
+ * @param quantity Number of items to store.
+ * @return Returns the number of items stored.
+ */
+int stock_add(struct Stock *stock, int model_id, int quantity) {
+    long long space = stock->space_required[model_id];
+    long long fitting = space > 0 ? stock_free_space(stock) / space : quantity;
+
+    if (quantity <= 0) {
+        return 0;
+    }
+    if (fitting < quantity) {
+        quantity = (int)fitting;
+    }
+    stock->quantity[model_id] += quantity;
+    stock->occupied_space += quantity * space;
+    return quantity;
+}
+
+/**
+ * Takes a whole order quantity of a model out of the stock, or nothing if not enough items are stored.
+ * @param stock Pointer reference to the Stock struct.
+ * @param model_id Position of the model in the models array.
+ * @param quantity Number of items wanted.
+ * @return True if the items were taken, otherwise false.
+ */
+bool stock_reserve(struct Stock *stock, int model_id, int quantity) {
+    if (stock->quantity[model_id] < quantity) {
+        return false;
+    }
+    stock->quantity[model_id] -= quantity;
+    stock->occupied_space -= (long long)quantity * stock->space_required[model_id];
+    return true;
+}
+
+/**
+ * Puts items previously reserved back into the stock, as long as they still fit in the free space.
+ * @param stock Pointer reference to the Stock struct.
+ * @param model_id Position of the model in the models array.
+ * @param quantity Number of items returned.
+ * @return Returns the number of items put back.
+ */
+int stock_release(struct Stock *stock, int model_id, int quantity) {
+    return stock_add(stock, model_id, quantity);
+}
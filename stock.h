@@ -0,0 +1,15 @@
+#ifndef ORDER_SYSTEM_STOCK_H
+#define ORDER_SYSTEM_STOCK_H
+#include <stdio.h>
+#include <stdbool.h>
+#include "order_system.h"
+/** @file */
+
+void stock_init(struct Stock *, int, struct ModelInfo *, int);
+void stock_free(struct Stock *);
+int stock_add(struct Stock *, int, int);
+bool stock_reserve(struct Stock *, int, int);
+int stock_release(struct Stock *, int, int);
+long long stock_free_space(struct Stock *);
+
+#endif //ORDER_SYSTEM_STOCK_H
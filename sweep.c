@@ -0,0 +1,256 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "sweep.h"
+#include "scheduler.h"
+#include "work_pool.h"
+#include "stock.h"
+
+/**
+ * Reads a parameter grid. Each line names a parameter followed by the values to try, for example
+ * "storage_capacity 100 200 400", "number_of_workers 20 40", "man_hours A 2 4", "space_required C 10 30" or
+ * "policy fcfs spt margin".
+ * Empty lines and lines starting with # are ignored.
+ * @param fptr Pointer to the grid file.
+ * @param grid Pointer reference to the SweepGrid struct to fill.
+ * @param catalog Pointer reference to the ModelCatalog struct.
+ * @return Returns 0 on success, -1 if the grid is not valid.
+ */
+int sweep_grid_read(FILE *fptr, struct SweepGrid *grid, struct ModelCatalog *catalog) {
+    char line[1024];
+    int line_number = 0;
+    long long scenarios = 1;
+
+    grid->axis_count = 0;
+    while (fgets(line, sizeof(line), fptr) != NULL) {
+        char *token = strtok(line, " \t\r\n");
+        struct SweepAxis *axis;
+
+        line_number++;
+        if (token == NULL || token[0] == '#') {
+            continue;
+        }
+        if (grid->axis_count == SWEEP_MAX_AXES) {
+            printf("Error! too many parameters in the sweep grid, line %d\n", line_number);
+            return -1;
+        }
+        axis = &grid->axes[grid->axis_count];
+        axis->model = 0;
+        axis->value_count = 0;
+
+        if (strcmp(token, "storage_capacity") == 0) {
+            axis->parameter = SWEEP_STORAGE_CAPACITY;
+        } else if (strcmp(token, "number_of_workers") == 0) {
+            axis->parameter = SWEEP_NUMBER_OF_WORKERS;
+        } else if (strcmp(token, "man_hours") == 0 || strcmp(token, "space_required") == 0) {
+            struct ModelInfo *model_info;
+
+            axis->parameter = strcmp(token, "man_hours") == 0 ? SWEEP_MAN_HOURS : SWEEP_SPACE_REQUIRED;
+            token = strtok(NULL, " \t\r\n");
+            model_info = token != NULL ? get_model_by_name(token, catalog) : NULL;
+            if (model_info == NULL) {
+                printf("Error! unknown model in the sweep grid, line %d\n", line_number);
+                return -1;
+            }
+            axis->model = (int)(model_info - catalog->models);
+        } else if (strcmp(token, "policy") == 0) {
+            axis->parameter = SWEEP_POLICY;
+        } else {
+            printf("Error! unknown parameter %s in the sweep grid, line %d\n", token, line_number);
+            return -1;
+        }
+
+        while ((token = strtok(NULL, " \t\r\n")) != NULL) {
+            char *end;
+            long value = strtol(token, &end, 10);
+
+            if (axis->parameter == SWEEP_POLICY) {
+                value = schedule_policy_parse(token);
+                end = value >= 0 ? token + strlen(token) : token;
+            }
+            if (*end != '\0' || value < (axis->parameter == SWEEP_POLICY ? 0 : 1) || value > INT_MAX || axis->value_count == SWEEP_MAX_VALUES) {
+                printf("Error! invalid value %s in the sweep grid, line %d\n", token, line_number);
+                return -1;
+            }
+            axis->values[axis->value_count++] = (int)value;
+        }
+        if (axis->value_count == 0) {
+            printf("Error! no values in the sweep grid, line %d\n", line_number);
+            return -1;
+        }
+
+        scenarios *= axis->value_count;
+        if (scenarios > INT_MAX) {
+            printf("Error! too many scenarios in the sweep grid\n");
+            return -1;
+        }
+        grid->axis_count++;
+    }
+
+    grid->scenario_count = (int)scenarios;
+    return 0;
+}
+
+/**
+ * Applies the parameter values of one scenario. The scenario index is read as a mixed radix number,
+ * the first axis varying fastest.
+ * @param grid Pointer reference to the SweepGrid struct.
+ * @param scenario Index of the scenario.
+ * @param system Pointer reference to the SystemInfo struct to change.
+ * @param models Pointer reference to the array of ModelInfo structs to change.
+ * @param policy Pointer reference to the scheduling policy to change.
+ */
+void sweep_scenario(struct SweepGrid *grid, int scenario, struct SystemInfo *system, struct ModelInfo *models, enum SchedulePolicy *policy) {
+    int i;
+
+    for (i = 0; i < grid->axis_count; ++i) {
+        struct SweepAxis *axis = &grid->axes[i];
+        int value = axis->values[scenario % axis->value_count];
+
+        scenario /= axis->value_count;
+        switch (axis->parameter) {
+            case SWEEP_STORAGE_CAPACITY:
+                system->storage_capacity = value;
+                break;
+            case SWEEP_NUMBER_OF_WORKERS:
+                system->number_of_workers = value;
+                break;
+            case SWEEP_MAN_HOURS:
+                models[axis->model].man_hours = value;
+                break;
+            case SWEEP_SPACE_REQUIRED:
+                models[axis->model].space_required = value;
+                break;
+            case SWEEP_POLICY:
+                *policy = (enum SchedulePolicy)value;
+                break;
+        }
+    }
+}
+
+/**
+ * Read only inputs shared by the sweep workers, and the table of results they fill.
+ */
+struct SweepContext {
+    struct SweepGrid *grid; /**< Parameter grid. */
+    const struct Order *orders; /**< Sorted orders, shared by every scenario. */
+    int orders_count; /**< Number of orders. */
+    struct ModelOrderingStats *stats; /**< Ordering stats, only read. */
+    struct SystemInfo *system; /**< Base system information. */
+    struct ModelCatalog *catalog; /**< Base model information. */
+    enum SchedulePolicy policy; /**< Base scheduling policy. */
+    struct SimulationResult *results; /**< Result of each scenario. */
+};
+
+/**
+ * Copies the model array of a catalog. The copy shares the name table, which is only read.
+ */
+static void copy_catalog(struct ModelCatalog *catalog, struct ModelCatalog *copy) {
+    *copy = *catalog;
+    copy->models = malloc((catalog->count > 0 ? catalog->count : 1) * sizeof(struct ModelInfo));
+    if (copy->models == NULL) {
+        printf("Error! not enough memory for the sweep\n");
+        exit(0);
+    }
+    memcpy(copy->models, catalog->models, catalog->count * sizeof(struct ModelInfo));
+}
+
+/**
+ * Simulates one scenario with private SystemInfo, ModelInfo and Stock state.
+ */
+static void run_scenario(int scenario, int worker, void *argument) {
+    struct SweepContext *context = argument;
+    struct SystemInfo system = *context->system;
+    struct ModelCatalog catalog;
+    struct Stock stock;
+    struct Scheduler scheduler;
+
+    (void)worker;
+    copy_catalog(context->catalog, &catalog);
+    scheduler_init(&scheduler, 1, NULL);
+    scheduler.policy = context->policy;
+    sweep_scenario(context->grid, scenario, &system, catalog.models, &scheduler.policy);
+    system.average_product_size = average_product_size(&catalog);
+    stock_init(&stock, system.storage_capacity, catalog.models, catalog.count);
+
+    simulate_orders(context->orders, context->orders_count, context->stats, &system, &stock, &catalog, &scheduler, &context->results[scenario]);
+    scheduler_free(&scheduler);
+    stock_free(&stock);
+    free(catalog.models);
+}
+
+/**
+ * Simulates every scenario of the grid on a work stealing pool and writes one CSV table with a row per scenario.
+ * Besides the system parameters, the table has the man hours and space of the models named by the grid.
+ * @param grid Pointer reference to the SweepGrid struct.
+ * @param orders Pointer reference to the array of Order structs, sorted by priority and never modified.
+ * @param orders_count Number of orders.
+ * @param stats Pointer reference to the ModelOrderingStats struct.
+ * @param system Pointer reference to the base SystemInfo struct.
+ * @param catalog Pointer reference to the base ModelCatalog struct.
+ * @param policy Base scheduling policy, for the grids without a policy axis.
+ * @param threads Number of threads, 0 to use every core.
+ * @param out File receiving the table.
+ */
+void sweep_run(struct SweepGrid *grid, const struct Order *orders, int orders_count, struct ModelOrderingStats *stats, struct SystemInfo *system, struct ModelCatalog *catalog, enum SchedulePolicy policy, int threads, FILE *out) {
+    int i, a;
+    struct SweepContext context;
+    struct ModelCatalog scenario_catalog;
+    bool *swept = calloc(catalog->count > 0 ? catalog->count : 1, sizeof(bool));
+
+    context.grid = grid;
+    context.orders = orders;
+    context.orders_count = orders_count;
+    context.stats = stats;
+    context.system = system;
+    context.catalog = catalog;
+    context.policy = policy;
+    context.results = calloc(grid->scenario_count, sizeof(struct SimulationResult));
+    if (context.results == NULL || swept == NULL) {
+        printf("Error! not enough memory for %d scenarios\n", grid->scenario_count);
+        exit(0);
+    }
+
+    work_pool_run(grid->scenario_count, work_pool_threads(threads), run_scenario, &context);
+
+    fprintf(out, "scenario,storage_capacity,number_of_workers,policy");
+    for (a = 0; a < grid->axis_count; ++a) {
+        struct SweepAxis *axis = &grid->axes[a];
+
+        if ((axis->parameter == SWEEP_MAN_HOURS || axis->parameter == SWEEP_SPACE_REQUIRED) && !swept[axis->model]) {
+            swept[axis->model] = true;
+            fprintf(out, ",man_hours_%s,space_required_%s", catalog->models[axis->model].model, catalog->models[axis->model].model);
+        }
+    }
+    fprintf(out, ",makespan,throughput,processed_orders,orders_from_stock,blocked_orders,idle_days\n");
+
+    copy_catalog(catalog, &scenario_catalog);
+    for (i = 0; i < grid->scenario_count; ++i) {
+        struct SystemInfo scenario_system = *system;
+        struct SimulationResult *result = &context.results[i];
+        enum SchedulePolicy scenario_policy = policy;
+
+        memcpy(scenario_catalog.models, catalog->models, catalog->count * sizeof(struct ModelInfo));
+        sweep_scenario(grid, i, &scenario_system, scenario_catalog.models, &scenario_policy);
+        fprintf(out, "%d,%d,%d,%s", i, scenario_system.storage_capacity, scenario_system.number_of_workers, schedule_policy_name(scenario_policy));
+        for (a = 0; a < catalog->count; ++a) {
+            swept[a] = false;
+        }
+        for (a = 0; a < grid->axis_count; ++a) {
+            struct SweepAxis *axis = &grid->axes[a];
+
+            if ((axis->parameter == SWEEP_MAN_HOURS || axis->parameter == SWEEP_SPACE_REQUIRED) && !swept[axis->model]) {
+                swept[axis->model] = true;
+                fprintf(out, ",%d,%d", scenario_catalog.models[axis->model].man_hours, scenario_catalog.models[axis->model].space_required);
+            }
+        }
+        fprintf(out, ",%d,%.6f,%d,%d,%d,%d\n", result->makespan, result->throughput, result->processed_orders, result->orders_from_stock, result->blocked_orders, result->idle_days);
+        simulation_result_free(result);
+    }
+
+    free(scenario_catalog.models);
+    free(swept);
+    free(context.results);
+}
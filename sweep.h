@@ -0,0 +1,44 @@
+#ifndef ORDER_SYSTEM_SWEEP_H
+#define ORDER_SYSTEM_SWEEP_H
+#include <stdio.h>
+#include <stdbool.h>
+#include "order_system.h"
+#define SWEEP_MAX_AXES 32
+#define SWEEP_MAX_VALUES 64
+/** @file */
+
+/**
+ * Parameters of info.dat which a sweep can vary.
+ */
+enum SweepParameter {
+    SWEEP_STORAGE_CAPACITY, /**< SystemInfo.storage_capacity */
+    SWEEP_NUMBER_OF_WORKERS, /**< SystemInfo.number_of_workers */
+    SWEEP_MAN_HOURS, /**< ModelInfo.man_hours of one model */
+    SWEEP_SPACE_REQUIRED, /**< ModelInfo.space_required of one model */
+    SWEEP_POLICY /**< Scheduling policy, the values are enum SchedulePolicy */
+};
+
+/**
+ * One axis of the parameter grid: the values tried for one parameter.
+ */
+struct SweepAxis {
+    enum SweepParameter parameter; /**< Parameter varied. */
+    int model; /**< Position of the model in the models array, for the per-model parameters. */
+    int values[SWEEP_MAX_VALUES]; /**< Values tried. */
+    int value_count; /**< Number of values. */
+};
+
+/**
+ * Parameter grid of a capacity sweep. Every combination of the axis values is one scenario.
+ */
+struct SweepGrid {
+    struct SweepAxis axes[SWEEP_MAX_AXES]; /**< Axes of the grid. */
+    int axis_count; /**< Number of axes. */
+    int scenario_count; /**< Product of the number of values of the axes. */
+};
+
+int sweep_grid_read(FILE *, struct SweepGrid *, struct ModelCatalog *);
+void sweep_scenario(struct SweepGrid *, int, struct SystemInfo *, struct ModelInfo *, enum SchedulePolicy *);
+void sweep_run(struct SweepGrid *, const struct Order *, int, struct ModelOrderingStats *, struct SystemInfo *, struct ModelCatalog *, enum SchedulePolicy, int, FILE *);
+
+#endif //ORDER_SYSTEM_SWEEP_H
@@ -0,0 +1,155 @@
+/** @file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "work_pool.h"
+
+/**
+ * State shared by the workers of a pool run.
+ */
+struct WorkPool {
+    struct WorkRange *ranges; /**< Range of tasks of each worker. */
+    int thread_count; /**< Number of workers. */
+    WorkTask task; /**< Function running a task. */
+    void *context; /**< Argument of the task function. */
+};
+
+/**
+ * Argument of a worker thread.
+ */
+struct Worker {
+    struct WorkPool *pool; /**< Pool the worker belongs to. */
+    int index; /**< Index of the worker. */
+};
+
+/**
+ * Gives the number of threads to use.
+ * @param requested Number of threads asked for, 0 or less to use one per online core.
+ * @return Returns the number of threads.
+ */
+int work_pool_threads(int requested) {
+    long cores;
+
+    if (requested > 0) {
+        return requested;
+    }
+    cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+/**
+ * Takes the next task from the front of the worker's own range.
+ * @return Returns the task index, or -1 if the range is empty.
+ */
+static int take_own(struct WorkRange *range) {
+    int task = -1;
+
+    pthread_mutex_lock(&range->lock);
+    if (range->begin < range->end) {
+        task = range->begin++;
+    }
+    pthread_mutex_unlock(&range->lock);
+    return task;
+}
+
+/**
+ * Steals the back half of another worker's range into the worker's own range.
+ * @return Returns 1 if some tasks were stolen, 0 if every other range is empty.
+ */
+static int steal(struct WorkPool *pool, int thief) {
+    int i;
+
+    for (i = 1; i < pool->thread_count; ++i) {
+        struct WorkRange *victim = &pool->ranges[(thief + i) % pool->thread_count];
+        int begin = 0, end = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        if (victim->begin < victim->end) {
+            end = victim->end;
+            begin = victim->begin + (victim->end - victim->begin) / 2;
+            victim->end = begin;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (begin < end) {
+            pthread_mutex_lock(&pool->ranges[thief].lock);
+            pool->ranges[thief].begin = begin;
+            pool->ranges[thief].end = end;
+            pthread_mutex_unlock(&pool->ranges[thief].lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Runs the worker's own tasks, then steals from the others until no task is left.
+ */
+static void *worker_main(void *argument) {
+    struct Worker *worker = argument;
+    struct WorkPool *pool = worker->pool;
+    int task;
+
+    do {
+        while ((task = take_own(&pool->ranges[worker->index])) >= 0) {
+            pool->task(task, worker->index, pool->context);
+        }
+    } while (steal(pool, worker->index));
+    return NULL;
+}
+
+/**
+ * Runs task_count tasks on a pool of threads with work stealing. Each worker starts with an equal slice of the
+ * tasks and, once done, steals half of the remaining tasks of another worker, so uneven tasks still keep every
+ * core busy. Returns when every task has been run.
+ * @param task_count Number of tasks.
+ * @param thread_count Number of threads, see work_pool_threads.
+ * @param task Function running one task.
+ * @param context Argument given to every call of task.
+ */
+void work_pool_run(int task_count, int thread_count, WorkTask task, void *context) {
+    int i;
+    struct WorkPool pool;
+    struct Worker *workers;
+    pthread_t *threads;
+
+    if (thread_count > task_count) {
+        thread_count = task_count > 0 ? task_count : 1;
+    }
+    pool.thread_count = thread_count;
+    pool.task = task;
+    pool.context = context;
+    pool.ranges = malloc(thread_count * sizeof(struct WorkRange));
+    workers = malloc(thread_count * sizeof(struct Worker));
+    threads = malloc(thread_count * sizeof(pthread_t));
+    if (pool.ranges == NULL || workers == NULL || threads == NULL) {
+        printf("Error! not enough memory for %d threads\n", thread_count);
+        exit(0);
+    }
+
+    for (i = 0; i < thread_count; ++i) {
+        pool.ranges[i].begin = (int)((long long)task_count * i / thread_count);
+        pool.ranges[i].end = (int)((long long)task_count * (i + 1) / thread_count);
+        pthread_mutex_init(&pool.ranges[i].lock, NULL);
+        workers[i].pool = &pool;
+        workers[i].index = i;
+    }
+
+    for (i = 1; i < thread_count; ++i) {
+        if (pthread_create(&threads[i], NULL, worker_main, &workers[i]) != 0) {
+            printf("Error! can not start thread %d\n", i);
+            exit(0);
+        }
+    }
+    worker_main(&workers[0]);
+    for (i = 1; i < thread_count; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (i = 0; i < thread_count; ++i) {
+        pthread_mutex_destroy(&pool.ranges[i].lock);
+    }
+    free(pool.ranges);
+    free(workers);
+    free(threads);
+}
@@ -0,0 +1,26 @@
+#ifndef ORDER_SYSTEM_WORK_POOL_H
+#define ORDER_SYSTEM_WORK_POOL_H
+#include <pthread.h>
+/** @file */
+
+/**
+ * Tasks still to be run by one worker of the pool, [begin, end). Other workers steal from its end.
+ */
+struct WorkRange {
+    int begin; /**< Next task the owner will run. */
+    int end; /**< End of the range. */
+    pthread_mutex_t lock; /**< Protects begin and end. */
+};
+
+/**
+ * Function running one task of the pool.
+ * @param task Index of the task.
+ * @param worker Index of the worker running it, to address per-thread state.
+ * @param context Pointer given to work_pool_run.
+ */
+typedef void (*WorkTask)(int task, int worker, void *context);
+
+int work_pool_threads(int);
+void work_pool_run(int, int, WorkTask, void *);
+
+#endif //ORDER_SYSTEM_WORK_POOL_H